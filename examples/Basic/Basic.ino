@@ -40,6 +40,15 @@ void setup() {
 	    10000
 	);
 
+	// Called every 250 ms for 5000 ms with the number of ticks left
+	timer.setCounter(
+	    [](uint32_t ticksLeft) {
+		    Serial.printf("%lu ticks left so far\n", static_cast<unsigned long>(ticksLeft));
+	    },
+	    5000,
+	    250
+	);
+
 	// Example: pause then resume interval, then clear
 	timer.setTimeout(
 	    [t2]() {
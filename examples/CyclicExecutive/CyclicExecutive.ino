@@ -0,0 +1,50 @@
+// Demonstrates a cyclic executive for fixed-rate control loops
+#include <Arduino.h>
+#include <ESPTimer.h>
+
+ESPTimer timer;
+
+volatile uint32_t currentLoops = 0;
+volatile uint32_t speedLoops = 0;
+volatile uint32_t overrunCount = 0;
+
+// 1 ms minor frame, 10 ms major frame. Offsets keep the slower loops out of the frames the
+// current loop shares with them.
+const ESPTimerCyclicTask controlTable[] = {
+    {1, 0, []() { currentLoops = currentLoops + 1; }},
+    {5, 2, []() { speedLoops = speedLoops + 1; }},
+    {10,
+     3,
+     []() {
+	     Serial.printf(
+	         "current=%lu speed=%lu\n",
+	         static_cast<unsigned long>(currentLoops),
+	         static_cast<unsigned long>(speedLoops)
+	     );
+     }},
+};
+
+void setup() {
+	Serial.begin(115200);
+	delay(500);
+
+	timer.init();
+
+	ESPTimerCyclicConfig cfg;
+	cfg.core = 1;
+	cfg.onOverrun = [](uint32_t, uint32_t) { overrunCount = overrunCount + 1; };
+	if (!timer.startCyclic(controlTable, cfg)) {
+		Serial.println("Cyclic schedule rejected");
+	}
+}
+
+void loop() {
+	delay(1000);
+	const ESPTimerCyclicStats stats = timer.cyclicStats();
+	Serial.printf(
+	    "frames=%lu overruns=%lu maxFrameUs=%lu\n",
+	    static_cast<unsigned long>(stats.frames),
+	    static_cast<unsigned long>(stats.overruns),
+	    static_cast<unsigned long>(stats.maxFrameUs)
+	);
+}
@@ -1,33 +1,90 @@
 #include "timer.h"
 
+#include <algorithm>
 #include <type_traits>
 #include <utility>
 
 namespace {
+#if defined(portNUM_PROCESSORS)
+constexpr uint8_t kCoreCount = portNUM_PROCESSORS;
+#else
+constexpr uint8_t kCoreCount = 1;
+#endif
+
 template <typename Callback, typename... Args>
-void invokeTimerCallback(const Callback &callback, Args... args) noexcept {
+auto invokeTimerCallback(const Callback &callback, Args... args) noexcept
+    -> decltype(callback(args...)) {
+	using Result = decltype(callback(args...));
 	if (!callback) {
-		return;
+		return Result();
 	}
 
 #if defined(__cpp_exceptions)
 	try {
-		callback(args...);
+		return callback(args...);
 	} catch (...) {
 		// Library-owned code must never let callbacks unwind through worker tasks.
 	}
+	return Result();
 #else
-	callback(args...);
+	return callback(args...);
 #endif
 }
+uint64_t greatestCommonDivisor(uint64_t a, uint64_t b) {
+	while (b != 0) {
+		const uint64_t rest = a % b;
+		a = b;
+		b = rest;
+	}
+	return a;
+}
 } // namespace
 
 ESPTimer::ESPTimer() {
 	mutex_ = xSemaphoreCreateMutex();
+	exited_ = xEventGroupCreate();
+	if (exited_) {
+		xEventGroupSetBits(exited_, kLaneExitBits | kExecutorExitBits | kCyclicExitBit);
+	}
+	for (uint8_t i = 0; i < kMaxShards; ++i) {
+		shards_[i].owner = this;
+		shards_[i].timeouts.shard = i;
+		shards_[i].intervals.shard = i;
+		shards_[i].counters.shard = i;
+	}
+	for (Executor &executor : executors_) {
+		executor.owner = this;
+		executor.mutex = xSemaphoreCreateMutex();
+	}
+	forEachLane([](auto &lane) {
+		lane.mutex = xSemaphoreCreateMutex();
+		lane.batchDone = xSemaphoreCreateBinary();
+	});
 }
 
 ESPTimer::~ESPTimer() {
-	deinit();
+	// Nothing below may be freed while a worker still runs.
+	deinit(portMAX_DELAY);
+	forEachLane([](auto &lane) {
+		if (lane.mutex) {
+			vSemaphoreDelete(lane.mutex);
+			lane.mutex = nullptr;
+		}
+		if (lane.batchDone) {
+			vSemaphoreDelete(lane.batchDone);
+			lane.batchDone = nullptr;
+		}
+	});
+	for (Executor &executor : executors_) {
+		if (executor.mutex) {
+			vSemaphoreDelete(executor.mutex);
+			executor.mutex = nullptr;
+		}
+	}
+	if (exited_) {
+		vEventGroupDelete(exited_);
+		exited_ = nullptr;
+	}
 	if (mutex_) {
 		vSemaphoreDelete(mutex_);
 		mutex_ = nullptr;
@@ -47,624 +104,1462 @@ void ESPTimer::unlock() const {
 	}
 }
 
-uint32_t ESPTimer::nextIdLocked() {
-	uint32_t id = nextId_++;
-	if (nextId_ == 0) {
-		nextId_ = 1;
+uint32_t ESPTimer::makeId(Type type, uint8_t shard, uint16_t generation, size_t index) {
+	return (static_cast<uint32_t>(type) << kIdTypeShift) |
+	       (static_cast<uint32_t>(shard) << kIdShardShift) |
+	       (static_cast<uint32_t>(generation) << kIdIndexBits) | static_cast<uint32_t>(index);
+}
+
+bool ESPTimer::decodeId(
+    uint32_t id,
+    Type &type,
+    uint8_t &shard,
+    uint16_t &generation,
+    size_t &index
+) {
+	const uint32_t lane = id >> kIdTypeShift;
+	shard = static_cast<uint8_t>((id >> kIdShardShift) & 1u);
+	generation = static_cast<uint16_t>(id >> kIdIndexBits);
+	index = id & (kMaxSlotsPerLane - 1u);
+	if (generation == 0 || lane > static_cast<uint32_t>(Type::Counter)) {
+		return false;
+	}
+	type = static_cast<Type>(lane);
+	return true;
+}
+
+// Deadlines are compared relative to `now` so the 32-bit millisecond clock may wrap freely as
+// long as no deadline lies more than ~24 days in the future.
+bool ESPTimer::deadlineReached(uint32_t now, uint32_t deadline) {
+	return static_cast<int32_t>(now - deadline) >= 0;
+}
+
+// Tick-mode counters fire on the boundaries `endAtMs - k * tickMs`, where the reported ticks
+// left change, so late wakeups never shift later ticks. Other modes fire `tickMs` after `now`.
+// Either way the result is clamped to the deadline so the final call lands on it.
+uint32_t ESPTimer::nextCounterTick(const CounterItem &item, uint32_t now) {
+	if (deadlineReached(now, item.endAtMs)) {
+		return item.endAtMs;
+	}
+	const uint32_t remaining = item.endAtMs - now;
+	if (item.mode == CounterMode::Ticks) {
+		return item.endAtMs - ((remaining - 1) / item.tickMs) * item.tickMs;
+	}
+	return item.tickMs < remaining ? now + item.tickMs : item.endAtMs;
+}
+
+template <typename Item> constexpr ESPTimer::Type ESPTimer::laneType() {
+	if constexpr (std::is_same_v<Item, TimeoutItem>) {
+		return Type::Timeout;
+	} else if constexpr (std::is_same_v<Item, IntervalItem>) {
+		return Type::Interval;
+	} else {
+		return Type::Counter;
+	}
+}
+
+template <typename Item> uint32_t ESPTimer::nextDeadline(const Item &item) {
+	if constexpr (std::is_same_v<Item, TimeoutItem>) {
+		return item.dueAtMs;
+	} else if constexpr (std::is_same_v<Item, IntervalItem>) {
+		return item.lastFireMs + item.periodMs;
+	} else {
+		return item.nextTickMs;
 	}
-	return id;
 }
 
 ESPTimerConfig ESPTimer::normalizeConfig(const ESPTimerConfig &cfg) const {
 	ESPTimerConfig normalized = cfg;
+	foldLegacyCounterFields(normalized);
 	if (normalized.stackSizeTimeout == 0) {
 		normalized.stackSizeTimeout = 4096 * sizeof(StackType_t);
 	}
 	if (normalized.stackSizeInterval == 0) {
 		normalized.stackSizeInterval = 4096 * sizeof(StackType_t);
 	}
-	if (normalized.stackSizeSec == 0) {
-		normalized.stackSizeSec = 4096 * sizeof(StackType_t);
+	if (normalized.stackSizeCounter == 0) {
+		normalized.stackSizeCounter = 4096 * sizeof(StackType_t);
 	}
-	if (normalized.stackSizeMs == 0) {
-		normalized.stackSizeMs = 4096 * sizeof(StackType_t);
+	if (normalized.stackSizeExecutor == 0) {
+		normalized.stackSizeExecutor = 4096 * sizeof(StackType_t);
 	}
-	if (normalized.stackSizeMin == 0) {
-		normalized.stackSizeMin = 4096 * sizeof(StackType_t);
+
+	auto clampCapacity = [](uint16_t &capacity) {
+		if (capacity > kMaxSlotsPerLane) {
+			capacity = kMaxSlotsPerLane;
+		}
+	};
+	clampCapacity(normalized.maxTimeouts);
+	clampCapacity(normalized.maxIntervals);
+	clampCapacity(normalized.maxCounters);
+	if (normalized.elasticMaxSlots == 0) {
+		normalized.elasticMaxSlots = kMaxSlotsPerLane;
 	}
+	clampCapacity(normalized.elasticMaxSlots);
 	return normalized;
 }
 
-template <typename Item> void ESPTimer::resetItem(Item &item, Type type) {
-	Item cleared{};
-	cleared.type = type;
-	item = std::move(cleared);
-}
-
-template <typename Item> Item *ESPTimer::findFreeSlot(TimerVector<Item> &vec) {
-	for (auto &item : vec) {
-		if (!item.active) {
-			return &item;
-		}
+// Sketches written against the separate sec/ms/min workers keep their sizing: every counter
+// field left at its default takes the largest stack, the highest priority, the first pinned core
+// and the summed capacity of the old fields.
+void ESPTimer::foldLegacyCounterFields(ESPTimerConfig &cfg) {
+	if (cfg.stackSizeCounter == 0) {
+		cfg.stackSizeCounter = std::max({cfg.stackSizeSec, cfg.stackSizeMs, cfg.stackSizeMin});
+	}
+	if (cfg.priorityCounter == 0) {
+		cfg.priorityCounter = std::max({cfg.prioritySec, cfg.priorityMs, cfg.priorityMin});
+	}
+	if (cfg.coreCounter < 0) {
+		cfg.coreCounter = cfg.coreMs >= 0    ? cfg.coreMs
+		                  : cfg.coreSec >= 0 ? cfg.coreSec
+		                                     : cfg.coreMin;
+	}
+	if (cfg.maxCounters == 0) {
+		const uint32_t sum = uint32_t{cfg.maxSecCounters} + cfg.maxMsCounters + cfg.maxMinCounters;
+		cfg.maxCounters = static_cast<uint16_t>(std::min<uint32_t>(sum, kMaxSlotsPerLane));
 	}
-	return nullptr;
 }
 
-template <typename Item> Item *ESPTimer::findItemById(TimerVector<Item> &vec, uint32_t id) {
-	for (auto &item : vec) {
-		if (item.active && item.id == id) {
-			return &item;
-		}
-	}
-	return nullptr;
+// Each setting is read on its own, so relaxed stores are enough: a reader sees either value.
+void ESPTimer::Tunables::store(const ESPTimerConfig &cfg) {
+	staggerIntervals.store(cfg.staggerIntervals, std::memory_order_relaxed);
+	orderDispatch.store(cfg.orderDispatch, std::memory_order_relaxed);
+	laneBudgetUs.store(cfg.laneBudgetUs, std::memory_order_relaxed);
+	callbackBudgetUs.store(cfg.callbackBudgetUs, std::memory_order_relaxed);
+	admission.store(cfg.admission, std::memory_order_relaxed);
+	occupancyHighWaterPct.store(cfg.occupancyHighWaterPct, std::memory_order_relaxed);
+	latenessHighWaterMs.store(cfg.latenessHighWaterMs, std::memory_order_relaxed);
+	elasticReclaimMs.store(cfg.elasticReclaimMs, std::memory_order_relaxed);
 }
 
-template <typename Item>
-const Item *ESPTimer::findItemById(const TimerVector<Item> &vec, uint32_t id) const {
-	for (const auto &item : vec) {
-		if (item.active && item.id == id) {
-			return &item;
-		}
+ESPTimerMemoryRegion ESPTimer::resolveRegion(ESPTimerMemoryRegion region) const {
+	if (region != ESPTimerMemoryRegion::Default) {
+		return region;
 	}
-	return nullptr;
+	return cfg_.usePSRAMBuffers ? ESPTimerMemoryRegion::PSRAM : ESPTimerMemoryRegion::Default;
 }
 
-template <typename Item> void ESPTimer::clearStoppedLocked(TimerVector<Item> &vec, Type type) {
-	for (auto &item : vec) {
-		if (item.active && !item.executing &&
-		    (item.status == ESPTimerStatus::Stopped || item.status == ESPTimerStatus::Completed)) {
-			resetItem(item, type);
-		}
-	}
+template <typename Item> void ESPTimer::resetItem(Item &item) {
+	Item cleared{};
+	cleared.word.store(static_cast<uint32_t>(item.generation()) << BaseItem::kGenerationShift);
+	item = cleared;
 }
 
-bool ESPTimer::configureStorageLocked() {
-	TimerVector<TimeoutItem> timeoutStorage{TimerAllocator<TimeoutItem>(usePSRAMBuffers_)};
-	TimerVector<IntervalItem> intervalStorage{TimerAllocator<IntervalItem>(usePSRAMBuffers_)};
-	TimerVector<SecItem> secStorage{TimerAllocator<SecItem>(usePSRAMBuffers_)};
-	TimerVector<MsItem> msStorage{TimerAllocator<MsItem>(usePSRAMBuffers_)};
-	TimerVector<MinItem> minStorage{TimerAllocator<MinItem>(usePSRAMBuffers_)};
-
-	TimerVector<TimedDispatch> timeoutDispatch{TimerAllocator<TimedDispatch>(usePSRAMBuffers_)};
-	TimerVector<TimedDispatch> intervalDispatch{TimerAllocator<TimedDispatch>(usePSRAMBuffers_)};
-	TimerVector<SecDispatch> secDispatch{TimerAllocator<SecDispatch>(usePSRAMBuffers_)};
-	TimerVector<MsDispatch> msDispatch{TimerAllocator<MsDispatch>(usePSRAMBuffers_)};
-	TimerVector<MinDispatch> minDispatch{TimerAllocator<MinDispatch>(usePSRAMBuffers_)};
-
-	if (!timerTryAssign(timeoutStorage, cfg_.maxTimeouts, TimeoutItem{})) {
+// Elastic lanes start with `regularSlots` and may grow to the elastic limit, which then counts
+// as their regular size; fixed lanes allocate everything, overflow reserve included, up front.
+template <typename Item, typename Dispatch>
+bool ESPTimer::configureLane(Lane<Item, Dispatch> &lane, uint16_t regularSlots, bool withInbox) {
+	const size_t chunkSlots = cfg_.elasticChunkSlots;
+	const uint16_t limit = laneLimit(cfg_, regularSlots);
+	const uint16_t capacity = laneCapacity(cfg_, limit);
+	const uint16_t initial = chunkSlots > 0 ? regularSlots : capacity;
+
+	using Callback = typename Item::Callback;
+	TimerChunkedVector<Item> items(slotRegion_);
+	TimerSlotBitmap slots(slotRegion_);
+	TimerChunkedVector<Callback> callbacks(callbackRegion_);
+	TimerChunkedVector<EventTarget> events(callbackRegion_);
+	TimerChunkedVector<Waiters> waiters(slotRegion_);
+	TimerVector<Dispatch> dispatch{TimerAllocator<Dispatch>(dispatchRegion_)};
+	TimerInbox<ControlCommand> inbox(dispatchRegion_);
+
+	if (!items.configure(initial, chunkSlots, capacity)) {
 		return false;
 	}
-	if (!timerTryAssign(intervalStorage, cfg_.maxIntervals, IntervalItem{})) {
+	if (!slots.configure(capacity)) {
 		return false;
 	}
-	if (!timerTryAssign(secStorage, cfg_.maxSecCounters, SecItem{})) {
+	if (!callbacks.configure(initial, chunkSlots, capacity)) {
 		return false;
 	}
-	if (!timerTryAssign(msStorage, cfg_.maxMsCounters, MsItem{})) {
+	if (!events.configure(initial, chunkSlots, capacity)) {
 		return false;
 	}
-	if (!timerTryAssign(minStorage, cfg_.maxMinCounters, MinItem{})) {
+	if (!waiters.configure(initial, chunkSlots, capacity)) {
 		return false;
 	}
-
-	if (!timerTryReserve(timeoutDispatch, cfg_.maxTimeouts)) {
-		return false;
-	}
-	if (!timerTryReserve(intervalDispatch, cfg_.maxIntervals)) {
-		return false;
-	}
-	if (!timerTryReserve(secDispatch, cfg_.maxSecCounters)) {
+	if (!timerTryReserve(dispatch, initial)) {
 		return false;
 	}
-	if (!timerTryReserve(msDispatch, cfg_.maxMsCounters)) {
+	if (withInbox && capacity > 0 && !inbox.configure(initial < 8 ? 8 : initial)) {
 		return false;
 	}
-	if (!timerTryReserve(minDispatch, cfg_.maxMinCounters)) {
+	if (!lane.lock()) {
 		return false;
 	}
 
-	for (auto &item : timeoutStorage) {
-		resetItem(item, Type::Timeout);
-	}
-	for (auto &item : intervalStorage) {
-		resetItem(item, Type::Interval);
-	}
-	for (auto &item : secStorage) {
-		resetItem(item, Type::Sec);
-	}
-	for (auto &item : msStorage) {
-		resetItem(item, Type::Ms);
-	}
-	for (auto &item : minStorage) {
-		resetItem(item, Type::Min);
-	}
+	lane.items.swap(items);
+	lane.slots.swap(slots);
+	lane.callbacks.swap(callbacks);
+	lane.events.swap(events);
+	lane.waiters.swap(waiters);
+	lane.dispatch.swap(dispatch);
+	lane.inbox.swap(inbox);
+	lane.regularSlots = limit;
+	lane.sizedSlots = regularSlots;
+	lane.sizedChunkSlots = static_cast<uint16_t>(chunkSlots);
+	lane.baseChunks = static_cast<uint16_t>(lane.items.chunks());
+	lane.retiredGeneration = 0;
+	lane.topChunkIdle = false;
+	lane.unlock();
+	return true;
+}
 
-	timeouts_.swap(timeoutStorage);
-	intervals_.swap(intervalStorage);
-	secs_.swap(secStorage);
-	mss_.swap(msStorage);
-	mins_.swap(minStorage);
+// Regular slots of a lane once fully grown: its starting size, or the elastic limit.
+uint16_t ESPTimer::laneLimit(const ESPTimerConfig &cfg, uint16_t regularSlots) {
+	return cfg.elasticChunkSlots > 0 ? std::max(regularSlots, cfg.elasticMaxSlots) : regularSlots;
+}
 
-	timeoutDispatch_.swap(timeoutDispatch);
-	intervalDispatch_.swap(intervalDispatch);
-	secDispatch_.swap(secDispatch);
-	msDispatch_.swap(msDispatch);
-	minDispatch_.swap(minDispatch);
-	return true;
+// Regular slots plus the overflow reserve, within the per-lane limit.
+uint16_t ESPTimer::laneCapacity(const ESPTimerConfig &cfg, uint16_t regularSlots) {
+	if (cfg.admission != ESPTimerAdmission::Overflow) {
+		return regularSlots;
+	}
+	const uint32_t capacity = static_cast<uint32_t>(regularSlots) + cfg.overflowSlots;
+	return static_cast<uint16_t>(std::min<uint32_t>(capacity, kMaxSlotsPerLane));
 }
 
-void ESPTimer::releaseStorageLocked() {
-	TimerVector<TimeoutItem>(TimerAllocator<TimeoutItem>(usePSRAMBuffers_)).swap(timeouts_);
-	TimerVector<IntervalItem>(TimerAllocator<IntervalItem>(usePSRAMBuffers_)).swap(intervals_);
-	TimerVector<SecItem>(TimerAllocator<SecItem>(usePSRAMBuffers_)).swap(secs_);
-	TimerVector<MsItem>(TimerAllocator<MsItem>(usePSRAMBuffers_)).swap(mss_);
-	TimerVector<MinItem>(TimerAllocator<MinItem>(usePSRAMBuffers_)).swap(mins_);
+template <typename Item, typename Dispatch>
+void ESPTimer::releaseLane(Lane<Item, Dispatch> &lane) {
+	using Callback = typename Item::Callback;
+	TimerChunkedVector<Item> items(lane.items.region());
+	TimerSlotBitmap slots(lane.slots.region());
+	TimerChunkedVector<Callback> callbacks(lane.callbacks.region());
+	TimerChunkedVector<EventTarget> events(lane.events.region());
+	TimerChunkedVector<Waiters> waiters(lane.waiters.region());
+	TimerVector<Dispatch> dispatch(lane.dispatch.get_allocator());
+	TimerInbox<ControlCommand> inbox(lane.inbox.region());
+
+	// Swap under the lane lock, free outside of it: callback captures may be arbitrary.
+	// Tasks blocked in waitFor() and suspended coroutines are released first.
+	ESPTimerResumeNode *cancelled = nullptr;
+	if (lane.lock()) {
+		lane.slots.forEach([&](size_t index) { wakeWaiterLocked(lane, index, kWaitEndedBit); });
+		cancelled = takeResumableLocked(lane);
+		lane.items.swap(items);
+		lane.slots.swap(slots);
+		lane.callbacks.swap(callbacks);
+		lane.events.swap(events);
+		lane.waiters.swap(waiters);
+		lane.dispatch.swap(dispatch);
+		lane.inbox.swap(inbox);
+		lane.unlock();
+	}
+	resumeCoroutines(cancelled);
+}
 
-	TimerVector<TimedDispatch>(TimerAllocator<TimedDispatch>(usePSRAMBuffers_))
-	    .swap(timeoutDispatch_);
-	TimerVector<TimedDispatch>(TimerAllocator<TimedDispatch>(usePSRAMBuffers_))
-	    .swap(intervalDispatch_);
-	TimerVector<SecDispatch>(TimerAllocator<SecDispatch>(usePSRAMBuffers_)).swap(secDispatch_);
-	TimerVector<MsDispatch>(TimerAllocator<MsDispatch>(usePSRAMBuffers_)).swap(msDispatch_);
-	TimerVector<MinDispatch>(TimerAllocator<MinDispatch>(usePSRAMBuffers_)).swap(minDispatch_);
+template <typename Item, typename Dispatch>
+bool ESPTimer::laneFits(const Lane<Item, Dispatch> &lane, uint16_t capacity) const {
+	size_t top = 0;
+	if (!lane.lock()) {
+		return false;
+	}
+	lane.slots.forEach([&](size_t index) { top = index + 1; });
+	lane.unlock();
+	return top <= capacity;
 }
 
-bool ESPTimer::tryCreateWorkerLocked(
-    TaskFunction_t fn,
-    const char *name,
-    uint16_t stack,
-    UBaseType_t prio,
-    int8_t core,
-    TaskHandle_t &handle
+// True when the lane's pools were built for `regularSlots` under `cfg`. reconfigure() compares
+// against the lane rather than `cfg_`, so a lane a failed call could not move back is migrated
+// by the next one.
+template <typename Item, typename Dispatch>
+bool ESPTimer::laneMatches(
+    const Lane<Item, Dispatch> &lane,
+    const ESPTimerConfig &cfg,
+    uint16_t regularSlots
 ) {
-	handle = nullptr;
-	const BaseType_t coreId = core < 0 ? tskNO_AFFINITY : static_cast<BaseType_t>(core);
-	return xTaskCreatePinnedToCore(
-	           fn,
-	           name ? name : "ESPTimerTask",
-	           stack,
-	           this,
-	           prio,
-	           &handle,
-	           coreId
-	       ) == pdPASS &&
-	       handle != nullptr;
-}
-
-void ESPTimer::waitForWorkerExit(TaskHandle_t &handle) {
+	const uint16_t limit = laneLimit(cfg, regularSlots);
+	return lane.sizedSlots == regularSlots && lane.sizedChunkSlots == cfg.elasticChunkSlots &&
+	       lane.regularSlots == limit && lane.slots.capacity() == laneCapacity(cfg, limit);
+}
+
+// Moves a lane into pools sized for `regularSlots` under `cfg`. Every slot keeps its index and
+// generation, so IDs stay valid; slots that fall off the end pass their generations on through
+// `retiredGeneration`. Callbacks run from their slot outside the lock, so the swap waits until
+// the lane has no batch in flight, for at most `timeout`, and lock-free readers are sent to the
+// lock while it happens. Fails without touching the lane when a live timer sits above the new
+// capacity. The old pools are freed once the lane is unlocked.
+template <typename Item, typename Dispatch>
+bool ESPTimer::resizeLane(
+    Lane<Item, Dispatch> &lane,
+    const ESPTimerConfig &cfg,
+    uint16_t regularSlots,
+    TickType_t timeout
+) {
+	const size_t chunkSlots = cfg.elasticChunkSlots;
+	const uint16_t limit = laneLimit(cfg, regularSlots);
+	const uint16_t capacity = laneCapacity(cfg, limit);
+
+	using Callback = typename Item::Callback;
+	TimerChunkedVector<Item> items(lane.items.region());
+	TimerSlotBitmap slots(lane.slots.region());
+	TimerChunkedVector<Callback> callbacks(lane.callbacks.region());
+	TimerChunkedVector<EventTarget> events(lane.events.region());
+	TimerChunkedVector<Waiters> waiters(lane.waiters.region());
+	TimerVector<Dispatch> dispatch(lane.dispatch.get_allocator());
+	if (!slots.configure(capacity)) {
+		return false;
+	}
+
+	lane.exclusive.store(true);
+	waitForLockFreeUsers();
 	const TickType_t start = xTaskGetTickCount();
-	while (handle && (xTaskGetTickCount() - start) <= pdMS_TO_TICKS(500)) {
-		vTaskDelay(pdMS_TO_TICKS(10));
+	bool resized = false;
+	for (;;) {
+		if (!lane.lock()) {
+			break;
+		}
+		const size_t busy = lane.slots.findIf([&](size_t index) {
+			return lane.items[index].executing();
+		});
+		if (busy == lane.slots.capacity()) {
+			resized = true;
+			break;
+		}
+		lane.unlock();
+		if (xTaskGetTickCount() - start >= timeout) {
+			break;
+		}
+		vTaskDelay(pdMS_TO_TICKS(1));
+	}
+	if (!resized) {
+		lane.exclusive.store(false);
+		return false;
 	}
-	if (handle) {
-		vTaskDelete(handle);
-		handle = nullptr;
+
+	size_t top = 0;
+	lane.slots.forEach([&](size_t index) { top = index + 1; });
+	const size_t initial = chunkSlots > 0 ? std::max<size_t>(regularSlots, top) : capacity;
+	resized = top <= capacity && items.configure(initial, chunkSlots, capacity) &&
+	          callbacks.configure(initial, chunkSlots, capacity) &&
+	          events.configure(initial, chunkSlots, capacity) &&
+	          waiters.configure(initial, chunkSlots, capacity) &&
+	          timerTryReserve(dispatch, initial);
+	if (resized) {
+		const size_t kept = std::min(items.size(), lane.items.size());
+		for (size_t index = kept; index < lane.items.size(); ++index) {
+			lane.retiredGeneration =
+			    std::max(lane.retiredGeneration, lane.items[index].generation());
+		}
+		for (size_t index = 0; index < kept; ++index) {
+			items[index] = lane.items[index];
+		}
+		const uint32_t word = static_cast<uint32_t>(lane.retiredGeneration)
+		                      << BaseItem::kGenerationShift;
+		for (size_t index = kept; index < items.size(); ++index) {
+			items[index].publish(word);
+		}
+		lane.slots.forEach([&](size_t index) {
+			slots.claim(index);
+			callbacks[index] = std::move(lane.callbacks[index]);
+			events[index] = lane.events[index];
+			waiters[index] = lane.waiters[index];
+		});
+
+		lane.items.swap(items);
+		lane.slots.swap(slots);
+		lane.callbacks.swap(callbacks);
+		lane.events.swap(events);
+		lane.waiters.swap(waiters);
+		lane.dispatch.swap(dispatch); // empty: no batch is in flight
+		lane.regularSlots = limit;
+		lane.sizedSlots = regularSlots;
+		lane.sizedChunkSlots = static_cast<uint16_t>(chunkSlots);
+		const size_t chunkLength = lane.items.chunkLength();
+		lane.baseChunks = static_cast<uint16_t>(
+		    chunkSlots > 0 ? (regularSlots + chunkLength - 1) / chunkLength : lane.items.chunks()
+		);
+		lane.topChunkIdle = false;
+		lane.load.crowded.store(aboveOccupancyMark(lane), std::memory_order_relaxed);
+	}
+	lane.unlock();
+	lane.exclusive.store(false);
+	return resized;
+}
+
+template <typename Fn> void ESPTimer::forEachLane(Fn &&fn) {
+	for (Shard &shard : shards_) {
+		fn(shard.timeouts);
+		fn(shard.intervals);
+		fn(shard.counters);
 	}
 }
 
-void ESPTimer::markTaskExited(Type type) {
+template <typename Fn> bool ESPTimer::withLaneLocked(Shard &shard, Type type, Fn &&fn) {
+	auto run = [&](auto &lane) {
+		if (!lane.lock()) {
+			return false;
+		}
+		const bool initialized =
+		    lifecycleState_.load(std::memory_order_acquire) == LifecycleState::Initialized;
+		if (initialized) {
+			fn(lane);
+		}
+		lane.unlock();
+		return initialized;
+	};
+
 	switch (type) {
 	case Type::Timeout:
-		hTimeout_ = nullptr;
-		break;
+		return run(shard.timeouts);
 	case Type::Interval:
-		hInterval_ = nullptr;
-		break;
-	case Type::Sec:
-		hSec_ = nullptr;
-		break;
-	case Type::Ms:
-		hMs_ = nullptr;
-		break;
-	case Type::Min:
-		hMin_ = nullptr;
-		break;
+		return run(shard.intervals);
+	case Type::Counter:
+		return run(shard.counters);
 	}
+	return false;
 }
 
-void ESPTimer::init(const ESPTimerConfig &cfg) {
-	if (!lock()) {
-		return;
+ESPTimer::Shard &ESPTimer::shardFor(int8_t core) {
+	const uint8_t count = shardCount_.load(std::memory_order_relaxed);
+	if (count <= 1) {
+		return shards_[0];
 	}
+	const int32_t target = core < 0 ? static_cast<int32_t>(xPortGetCoreID()) : core;
+	return shards_[target > 0 && target < count ? target : 0];
+}
 
-	if (lifecycleState_.load(std::memory_order_acquire) != LifecycleState::Uninitialized) {
-		unlock();
-		return;
+uint8_t ESPTimer::currentShard() const {
+	const uint8_t count = shardCount_.load(std::memory_order_relaxed);
+	if (count <= 1) {
+		return 0;
 	}
+	const int32_t core = static_cast<int32_t>(xPortGetCoreID());
+	return static_cast<uint8_t>(core > 0 && core < count ? core : 0);
+}
 
-	lifecycleState_.store(LifecycleState::Initializing, std::memory_order_release);
-	cfg_ = normalizeConfig(cfg);
-	usePSRAMBuffers_ = cfg_.usePSRAMBuffers;
-	nextId_ = 1;
-
-	if (!configureStorageLocked()) {
-		lifecycleState_.store(LifecycleState::Uninitialized, std::memory_order_release);
-		unlock();
-		return;
-	}
+// Callers pick the lane from the ID's shard, so only the type, index and generation are checked.
+template <typename Item, typename Dispatch>
+Item *ESPTimer::findItemById(Lane<Item, Dispatch> &lane, uint32_t id, size_t &index) {
+	Type idType = Type::Timeout;
+	uint8_t shard = 0;
+	uint16_t generation = 0;
+	if (!decodeId(id, idType, shard, generation, index) || idType != laneType<Item>() ||
+	    !lane.slots.contains(index)) {
+		return nullptr;
+	}
+	Item &item = lane.items[index];
+	return item.generation() == generation ? &item : nullptr;
+}
 
-	running_.store(true, std::memory_order_release);
+template <typename Item, typename Dispatch>
+Item *ESPTimer::acquireSlotLocked(
+    Lane<Item, Dispatch> &lane,
+    size_t &index,
+    OverloadNotice &notice
+) {
+	const auto laneId = static_cast<ESPTimerLane>(laneType<Item>());
+	if (!admitLocked(lane, notice) || !growLaneLocked(lane) || !lane.slots.acquire(index)) {
+		lane.load.rejected.fetch_add(1, std::memory_order_relaxed);
+		notice.add({ESPTimerOverload::Kind::Rejected, laneId, lane.shard, 0});
+		return nullptr;
+	}
+	Item &item = lane.items[index];
+	resetItem(item);
+	uint16_t generation = static_cast<uint16_t>(item.generation() + 1);
+	if (generation == 0) {
+		generation = 1;
+	}
+	item.publish(static_cast<uint32_t>(generation) << BaseItem::kGenerationShift);
+	item.setPriority(ESPTimerPriority::Normal);
+
+	const auto used = static_cast<uint32_t>(lane.slots.size());
+	if (used > lane.load.peakSlots.load(std::memory_order_relaxed)) {
+		lane.load.peakSlots.store(used, std::memory_order_relaxed);
+	}
+	if (aboveOccupancyMark(lane) && !lane.load.crowded.exchange(true, std::memory_order_relaxed)) {
+		lane.load.occupancyAlarms.fetch_add(1, std::memory_order_relaxed);
+		notice.add({ESPTimerOverload::Kind::Occupancy, laneId, lane.shard, used});
+	}
+	return &item;
+}
 
-	const bool createdTimeout = tryCreateWorkerLocked(
-	    &ESPTimer::timeoutTaskTrampoline,
-	    "ESPTmrTimeout",
-	    cfg_.stackSizeTimeout,
-	    cfg_.priorityTimeout,
-	    cfg_.coreTimeout,
-	    hTimeout_
-	);
-	const bool createdInterval = createdTimeout && tryCreateWorkerLocked(
-	                                                   &ESPTimer::intervalTaskTrampoline,
-	                                                   "ESPTmrInterval",
-	                                                   cfg_.stackSizeInterval,
-	                                                   cfg_.priorityInterval,
-	                                                   cfg_.coreInterval,
-	                                                   hInterval_
-	                                               );
-	const bool createdSec = createdInterval && tryCreateWorkerLocked(
-	                                               &ESPTimer::secTaskTrampoline,
-	                                               "ESPTmrSec",
-	                                               cfg_.stackSizeSec,
-	                                               cfg_.prioritySec,
-	                                               cfg_.coreSec,
-	                                               hSec_
-	                                           );
-	const bool createdMs = createdSec && tryCreateWorkerLocked(
-	                                         &ESPTimer::msTaskTrampoline,
-	                                         "ESPTmrMs",
-	                                         cfg_.stackSizeMs,
-	                                         cfg_.priorityMs,
-	                                         cfg_.coreMs,
-	                                         hMs_
-	                                     );
-	const bool createdMin = createdMs && tryCreateWorkerLocked(
-	                                         &ESPTimer::minTaskTrampoline,
-	                                         "ESPTmrMin",
-	                                         cfg_.stackSizeMin,
-	                                         cfg_.priorityMin,
-	                                         cfg_.coreMin,
-	                                         hMin_
-	                                     );
-
-	if (!(createdTimeout && createdInterval && createdSec && createdMs && createdMin)) {
-		running_.store(false, std::memory_order_release);
-		lifecycleState_.store(LifecycleState::Deinitializing, std::memory_order_release);
-		unlock();
+// Applies the admission policy once the regular slots are used up. EvictLow picks the Low-class
+// timer whose next deadline is furthest away, skipping in-flight timers and persistent handles.
+template <typename Item, typename Dispatch>
+bool ESPTimer::admitLocked(Lane<Item, Dispatch> &lane, OverloadNotice &notice) {
+	if (lane.slots.size() < lane.regularSlots) {
+		return true;
+	}
 
-		waitForWorkerExit(hTimeout_);
-		waitForWorkerExit(hInterval_);
-		waitForWorkerExit(hSec_);
-		waitForWorkerExit(hMs_);
-		waitForWorkerExit(hMin_);
+	const ESPTimerAdmission admission = tunables_.admission.load(std::memory_order_relaxed);
+	if (admission == ESPTimerAdmission::Overflow) {
+		if (lane.slots.size() >= lane.slots.capacity()) {
+			return false;
+		}
+		lane.load.overflowed.fetch_add(1, std::memory_order_relaxed);
+		return true;
+	}
+	if (admission != ESPTimerAdmission::EvictLow) {
+		return false;
+	}
 
-		if (lock()) {
-			releaseStorageLocked();
-			lifecycleState_.store(LifecycleState::Uninitialized, std::memory_order_release);
-			unlock();
+	const uint32_t now = millis();
+	size_t victim = lane.slots.capacity();
+	int32_t furthest = 0;
+	lane.slots.forEach([&](size_t index) {
+		const Item &item = lane.items[index];
+		if (item.priority() != static_cast<uint8_t>(ESPTimerPriority::Low) || item.executing() ||
+		    item.persistent()) {
+			return;
 		}
-		return;
+		const auto untilDue = static_cast<int32_t>(nextDeadline(item) - now);
+		if (victim == lane.slots.capacity() || untilDue > furthest) {
+			victim = index;
+			furthest = untilDue;
+		}
+	});
+	if (victim == lane.slots.capacity()) {
+		return false;
 	}
 
-	lifecycleState_.store(LifecycleState::Initialized, std::memory_order_release);
-	unlock();
+	const uint16_t generation = lane.items[victim].generation();
+	const uint32_t id = makeId(laneType<Item>(), lane.shard, generation, victim);
+	releaseSlotLocked(lane, victim);
+	lane.load.evicted.fetch_add(1, std::memory_order_relaxed);
+	const auto laneId = static_cast<ESPTimerLane>(laneType<Item>());
+	notice.add({ESPTimerOverload::Kind::Evicted, laneId, lane.shard, id});
+	return true;
 }
 
-void ESPTimer::deinit() {
-	if (!lock()) {
-		return;
-	}
+// Empties the staging buffer for the next scan and sizes it to the lane. A lane can grow while
+// a batch still reads the buffer, so the worker reserves room for new chunks here, between
+// batches, in one allocation instead of one per staged timer.
+template <typename Item, typename Dispatch>
+void ESPTimer::resetStagingLocked(Lane<Item, Dispatch> &lane) {
+	lane.dispatch.clear();
+	timerTryReserve(lane.dispatch, lane.items.size());
+}
 
-	const LifecycleState state = lifecycleState_.load(std::memory_order_acquire);
-	if (state == LifecycleState::Uninitialized || state == LifecycleState::Deinitializing) {
-		unlock();
-		return;
+// Adds a chunk to every per-slot pool once all allocated slots are in use; all pools grow or
+// none does. Slot metadata grows last, because lock-free readers see it as soon as it grows.
+// New slots continue from the generations of reclaimed ones, so IDs issued before a reclaim
+// stay stale.
+template <typename Item, typename Dispatch>
+bool ESPTimer::growLaneLocked(Lane<Item, Dispatch> &lane) {
+	if (lane.slots.size() < lane.items.size()) {
+		return true;
 	}
+	if (!lane.callbacks.grow()) {
+		return false;
+	}
+	if (!lane.events.grow()) {
+		lane.callbacks.release(lane.callbacks.detachLast());
+		return false;
+	}
+	if (!lane.waiters.grow()) {
+		lane.events.release(lane.events.detachLast());
+		lane.callbacks.release(lane.callbacks.detachLast());
+		return false;
+	}
+	const size_t first = lane.items.size();
+	if (!lane.items.grow()) {
+		lane.waiters.release(lane.waiters.detachLast());
+		lane.events.release(lane.events.detachLast());
+		lane.callbacks.release(lane.callbacks.detachLast());
+		return false;
+	}
+	const uint32_t word = static_cast<uint32_t>(lane.retiredGeneration)
+	                      << BaseItem::kGenerationShift;
+	for (size_t index = first; index < lane.items.size(); ++index) {
+		lane.items[index].publish(word);
+	}
+	return true;
+}
 
-	lifecycleState_.store(LifecycleState::Deinitializing, std::memory_order_release);
-	running_.store(false, std::memory_order_release);
-	unlock();
-
-	waitForWorkerExit(hTimeout_);
-	waitForWorkerExit(hInterval_);
-	waitForWorkerExit(hSec_);
-	waitForWorkerExit(hMs_);
-	waitForWorkerExit(hMin_);
+// Detaches the last chunk once it has been empty for `elasticReclaimMs`. The slot metadata is
+// returned rather than freed, because lock-free readers may still be inside it; the worker
+// frees it with releaseChunk() after dropping the lock.
+template <typename Item, typename Dispatch>
+Item *ESPTimer::reclaimChunkLocked(Lane<Item, Dispatch> &lane, uint32_t now) {
+	if (lane.items.chunks() <= lane.baseChunks) {
+		return nullptr;
+	}
+	const size_t end = lane.items.size();
+	const size_t begin = end - lane.items.chunkLength();
+	if (lane.slots.anyInRange(begin, end)) {
+		lane.topChunkIdle = false;
+		return nullptr;
+	}
+	if (!lane.topChunkIdle) {
+		lane.topChunkIdle = true;
+		lane.topChunkIdleSinceMs = now;
+		return nullptr;
+	}
+	const uint32_t reclaimMs = tunables_.elasticReclaimMs.load(std::memory_order_relaxed);
+	if (now - lane.topChunkIdleSinceMs < reclaimMs) {
+		return nullptr;
+	}
+
+	for (size_t index = begin; index < end; ++index) {
+		lane.retiredGeneration = std::max(lane.retiredGeneration, lane.items[index].generation());
+	}
+	lane.topChunkIdle = false;
+	lane.callbacks.release(lane.callbacks.detachLast());
+	lane.events.release(lane.events.detachLast());
+	lane.waiters.release(lane.waiters.detachLast());
+	return lane.items.detachLast();
+}
 
-	if (!lock()) {
-		return;
+template <typename Item, typename Dispatch>
+void ESPTimer::releaseChunk(Lane<Item, Dispatch> &lane, Item *chunk) {
+	if (chunk) {
+		waitForLockFreeUsers();
+		lane.items.release(chunk);
 	}
+}
 
-	releaseStorageLocked();
-	nextId_ = 1;
-	cfg_ = ESPTimerConfig{};
-	usePSRAMBuffers_ = false;
-	lifecycleState_.store(LifecycleState::Uninitialized, std::memory_order_release);
-	unlock();
+template <typename Item, typename Dispatch>
+bool ESPTimer::aboveOccupancyMark(const Lane<Item, Dispatch> &lane) const {
+	const size_t markPct = tunables_.occupancyHighWaterPct.load(std::memory_order_relaxed);
+	return markPct > 0 && lane.slots.size() * 100 >= markPct * lane.regularSlots;
 }
 
-uint32_t ESPTimer::setTimeout(std::function<void()> cb, uint32_t delayMs) {
-	if (!cb || !lock()) {
-		return 0;
+void ESPTimer::reportOverload(const OverloadNotice &notice) const {
+	if (!cfg_.onOverload) {
+		return;
 	}
-	if (lifecycleState_.load(std::memory_order_acquire) != LifecycleState::Initialized) {
-		unlock();
-		return 0;
+	for (uint8_t i = 0; i < notice.count; ++i) {
+		cfg_.onOverload(notice.alarms[i]);
 	}
+}
 
-	TimeoutItem *slot = findFreeSlot(timeouts_);
-	if (!slot) {
-		unlock();
-		return 0;
+template <typename Item, typename Dispatch>
+void ESPTimer::releaseSlotLocked(Lane<Item, Dispatch> &lane, size_t index) {
+	wakeWaiterLocked(lane, index, kWaitEndedBit);
+	resetItem(lane.items[index]);
+	lane.callbacks[index] = nullptr;
+	lane.events[index] = EventTarget{};
+	lane.slots.release(index);
+	if (lane.load.crowded.load(std::memory_order_relaxed) && !aboveOccupancyMark(lane)) {
+		lane.load.crowded.store(false, std::memory_order_relaxed);
 	}
+}
 
-	resetItem(*slot, Type::Timeout);
-	slot->active = true;
-	slot->id = nextIdLocked();
-	slot->status = ESPTimerStatus::Running;
-	slot->createdMs = millis();
-	slot->dueAtMs = slot->createdMs + delayMs;
-	slot->cb = std::move(cb);
-
-	const uint32_t id = slot->id;
-	unlock();
-	return id;
+template <typename Item, typename Dispatch>
+void ESPTimer::addLaneFootprint(ESPTimerLaneFootprint &footprint, const Lane<Item, Dispatch> &lane)
+    const {
+	footprint.slots += lane.items.size();
+	footprint.slotBytes +=
+	    lane.items.memoryBytes() + lane.slots.memoryBytes() + lane.waiters.memoryBytes();
+	footprint.callbackBytes += lane.callbacks.memoryBytes() + lane.events.memoryBytes();
+	footprint.dispatchBytes +=
+	    lane.dispatch.capacity() * sizeof(Dispatch) + lane.inbox.memoryBytes();
 }
 
-uint32_t ESPTimer::setInterval(std::function<void()> cb, uint32_t periodMs) {
-	if (!cb || !lock()) {
-		return 0;
-	}
-	if (lifecycleState_.load(std::memory_order_acquire) != LifecycleState::Initialized) {
-		unlock();
-		return 0;
+// Runs every callback staged by the last scan without holding the lane lock, then applies all
+// completions under a single lock. Staged slots keep their executing flag until then, so clear*
+// only marks them Stopped and their callback storage stays valid for the whole batch. A timer
+// cleared after the scan is skipped instead of fired, and a one-shot re-armed while in flight
+// stays scheduled instead of completing. Completed persistent handles keep their slot.
+// Returns true when the lane budget deferred part of the batch, so the worker rescans at once.
+template <typename Item, typename Dispatch>
+bool ESPTimer::dispatchBatch(Lane<Item, Dispatch> &lane, bool oneShot) {
+	if (lane.dispatch.empty()) {
+		return false;
 	}
 
-	IntervalItem *slot = findFreeSlot(intervals_);
-	if (!slot) {
-		unlock();
-		return 0;
+	if (tunables_.orderDispatch.load(std::memory_order_relaxed)) {
+		orderBatch(lane.dispatch);
+	}
+	lane.batchStartUs = micros();
+	if (!stealableBatch(lane)) {
+		for (auto &dispatch : lane.dispatch) {
+			invokeDispatch(lane, dispatch);
+		}
 	}
 
-	resetItem(*slot, Type::Interval);
-	slot->active = true;
-	slot->id = nextIdLocked();
-	slot->status = ESPTimerStatus::Running;
-	slot->createdMs = millis();
-	slot->periodMs = periodMs;
-	slot->lastFireMs = slot->createdMs;
-	slot->cb = std::move(cb);
-
-	const uint32_t id = slot->id;
-	unlock();
-	return id;
+	if (!lane.lock()) {
+		return false;
+	}
+	bool deferred = false;
+	for (const auto &dispatch : lane.dispatch) {
+		if (dispatch.deferred) {
+			deferDispatchLocked(lane, dispatch);
+			deferred = true;
+			continue;
+		}
+		Item &item = lane.items[dispatch.index];
+		if constexpr (std::is_same_v<Item, CounterItem>) {
+			if (item.mode == CounterMode::Adaptive) {
+				item.tickMs = dispatch.nextMs > 0 ? dispatch.nextMs : 1;
+				item.nextTickMs = nextCounterTick(item, millis());
+			}
+		}
+		const bool rearmed = item.rearmed();
+		item.setExecuting(false);
+		item.setRearmed(false);
+		if (oneShot && !rearmed && item.status() == ESPTimerStatus::Running) {
+			item.setStatus(ESPTimerStatus::Completed);
+		}
+		if (item.status() != ESPTimerStatus::Stopped) {
+			wakeWaiterLocked(lane, dispatch.index, kWaitFiredBit);
+		}
+		if (item.status() == ESPTimerStatus::Stopped ||
+		    (item.status() == ESPTimerStatus::Completed && !item.persistent())) {
+			releaseSlotLocked(lane, dispatch.index);
+		}
+	}
+	lane.dispatch.clear();
+	ESPTimerResumeNode *ready = takeResumableLocked(lane);
+	lane.unlock();
+	resumeCoroutines(ready);
+	return deferred;
 }
 
-uint32_t ESPTimer::setSecCounter(std::function<void(int)> cb, uint32_t totalMs) {
-	if (!cb || !lock()) {
-		return 0;
+// Undoes what the scan did when it staged the entry, so the next scan finds the timer due
+// again: intervals get their previous fire time back and counters their pending tick.
+template <typename Item, typename Dispatch>
+void ESPTimer::deferDispatchLocked(Lane<Item, Dispatch> &lane, const Dispatch &dispatch) {
+	Item &item = lane.items[dispatch.index];
+	item.setExecuting(false);
+	item.setRearmed(false);
+	if constexpr (std::is_same_v<Item, IntervalItem>) {
+		item.lastFireMs = dispatch.dueAtMs - item.periodMs;
+	} else if constexpr (std::is_same_v<Item, CounterItem>) {
+		if (item.status() == ESPTimerStatus::Completed) {
+			item.setStatus(ESPTimerStatus::Running);
+		}
+		item.nextTickMs = dispatch.dueAtMs;
 	}
-	if (lifecycleState_.load(std::memory_order_acquire) != LifecycleState::Initialized) {
-		unlock();
-		return 0;
+	if (item.status() == ESPTimerStatus::Stopped) {
+		releaseSlotLocked(lane, dispatch.index);
 	}
+}
 
-	SecItem *slot = findFreeSlot(secs_);
-	if (!slot) {
-		unlock();
-		return 0;
+// Highest class first, then the longest-overdue deadline; the slot index breaks ties so the
+// order is deterministic. Sorts the preallocated staging buffer in place.
+template <typename Dispatch> void ESPTimer::orderBatch(TimerVector<Dispatch> &batch) {
+	if (batch.size() < 2) {
+		return;
 	}
-
-	resetItem(*slot, Type::Sec);
-	slot->active = true;
-	slot->id = nextIdLocked();
-	slot->status = ESPTimerStatus::Running;
-	slot->createdMs = millis();
-	slot->endAtMs = slot->createdMs + totalMs;
-	slot->lastTickMs = slot->createdMs;
-	slot->cb = std::move(cb);
-
-	const uint32_t id = slot->id;
-	unlock();
-	return id;
+	std::sort(batch.begin(), batch.end(), [](const Dispatch &a, const Dispatch &b) {
+		if (a.priority != b.priority) {
+			return a.priority > b.priority;
+		}
+		if (a.dueAtMs != b.dueAtMs) {
+			return static_cast<int32_t>(a.dueAtMs - b.dueAtMs) < 0;
+		}
+		return a.index < b.index;
+	});
 }
 
-uint32_t ESPTimer::setMsCounter(std::function<void(uint32_t)> cb, uint32_t totalMs) {
-	if (!cb || !lock()) {
-		return 0;
+template <typename Item, typename Dispatch>
+void ESPTimer::recordLateness(Lane<Item, Dispatch> &lane, uint32_t lateMs) {
+	// A deadline the scan saw as reached can only look "in the future" through wrap; count it
+	// as on time.
+	if (static_cast<int32_t>(lateMs) < 0) {
+		lateMs = 0;
+	}
+	uint32_t bucket = lateMs;
+	if (lateMs >= kLatenessLinearMs) {
+		const uint32_t octave = 31u - static_cast<uint32_t>(__builtin_clz(lateMs));
+		const uint32_t quarter = (lateMs >> (octave - 2)) & 3u;
+		bucket = kLatenessLinearMs + (octave - 5u) * 4u + quarter;
+		if (bucket >= kLatenessBuckets) {
+			bucket = kLatenessBuckets - 1;
+		}
 	}
-	if (lifecycleState_.load(std::memory_order_acquire) != LifecycleState::Initialized) {
-		unlock();
-		return 0;
+	lane.lateness[bucket].fetch_add(1, std::memory_order_relaxed);
+	uint32_t maxMs = lane.maxLatenessMs.load(std::memory_order_relaxed);
+	while (lateMs > maxMs &&
+	       !lane.maxLatenessMs.compare_exchange_weak(maxMs, lateMs, std::memory_order_relaxed)) {
 	}
 
-	MsItem *slot = findFreeSlot(mss_);
-	if (!slot) {
-		unlock();
-		return 0;
+	const uint32_t markMs = tunables_.latenessHighWaterMs.load(std::memory_order_relaxed);
+	if (markMs == 0) {
+		return;
+	}
+	const bool late = lateMs >= markMs;
+	if (lane.load.late.load(std::memory_order_relaxed) != late &&
+	    lane.load.late.exchange(late, std::memory_order_relaxed) != late && late) {
+		lane.load.latenessAlarms.fetch_add(1, std::memory_order_relaxed);
+		OverloadNotice notice;
+		const auto laneId = static_cast<ESPTimerLane>(laneType<Item>());
+		notice.add({ESPTimerOverload::Kind::Lateness, laneId, lane.shard, lateMs});
+		reportOverload(notice);
 	}
+}
 
-	resetItem(*slot, Type::Ms);
-	slot->active = true;
-	slot->id = nextIdLocked();
-	slot->status = ESPTimerStatus::Running;
-	slot->createdMs = millis();
-	slot->endAtMs = slot->createdMs + totalMs;
-	slot->lastTickMs = slot->createdMs;
-	slot->cb = std::move(cb);
+template <typename Item, typename Dispatch>
+void ESPTimer::addLaneLateness(
+    const Lane<Item, Dispatch> &lane,
+    uint32_t (&histogram)[kLatenessBuckets],
+    uint32_t &maxMs
+) {
+	for (uint32_t i = 0; i < kLatenessBuckets; ++i) {
+		histogram[i] += lane.lateness[i].load(std::memory_order_relaxed);
+	}
+	maxMs = std::max(maxMs, lane.maxLatenessMs.load(std::memory_order_relaxed));
+}
 
-	const uint32_t id = slot->id;
-	unlock();
-	return id;
+ESPTimerLateness
+ESPTimer::summarizeLateness(const uint32_t (&histogram)[kLatenessBuckets], uint32_t maxMs) {
+	ESPTimerLateness lateness;
+	for (uint32_t i = 0; i < kLatenessBuckets; ++i) {
+		lateness.samples += histogram[i];
+	}
+	if (lateness.samples == 0) {
+		return lateness;
+	}
+
+	// Rank of each percentile, rounded up, so p99 of 100 samples is the 99th smallest.
+	const uint32_t p50Rank = static_cast<uint32_t>((uint64_t(lateness.samples) * 50 + 99) / 100);
+	const uint32_t p99Rank = static_cast<uint32_t>((uint64_t(lateness.samples) * 99 + 99) / 100);
+	uint32_t seen = 0;
+	for (uint32_t i = 0; i < kLatenessBuckets; ++i) {
+		const uint32_t before = seen;
+		seen += histogram[i];
+		uint32_t upperMs = maxMs;
+		if (i < kLatenessLinearMs) {
+			upperMs = i;
+		} else if (i + 1 < kLatenessBuckets) {
+			const uint32_t octave = (i - kLatenessLinearMs) / 4 + 5;
+			const uint32_t quarter = (i - kLatenessLinearMs) % 4;
+			upperMs = ((5 + quarter) << (octave - 2)) - 1;
+		}
+		if (before < p50Rank && seen >= p50Rank) {
+			lateness.p50Ms = std::min(upperMs, maxMs);
+		}
+		if (before < p99Rank && seen >= p99Rank) {
+			lateness.p99Ms = std::min(upperMs, maxMs);
+			break;
+		}
+	}
+	lateness.maxMs = maxMs;
+	return lateness;
 }
 
-uint32_t ESPTimer::setMinCounter(std::function<void(int)> cb, uint32_t totalMs) {
-	if (!cb || !lock()) {
-		return 0;
+// Entries after the first are deferred once the batch has used up the lane budget. Overruns
+// are only checked when a callback budget and hook are set.
+template <typename Item, typename Dispatch>
+void ESPTimer::invokeDispatch(Lane<Item, Dispatch> &lane, Dispatch &dispatch) {
+	const Item &item = lane.items[dispatch.index];
+	if (item.status() == ESPTimerStatus::Stopped) {
+		return;
 	}
-	if (lifecycleState_.load(std::memory_order_acquire) != LifecycleState::Initialized) {
-		unlock();
-		return 0;
+	const uint32_t startUs = micros();
+	const uint32_t laneBudgetUs = tunables_.laneBudgetUs.load(std::memory_order_relaxed);
+	if (laneBudgetUs > 0 && &dispatch != &lane.dispatch[0] &&
+	    startUs - lane.batchStartUs >= laneBudgetUs) {
+		dispatch.deferred = true;
+		return;
 	}
 
-	MinItem *slot = findFreeSlot(mins_);
-	if (!slot) {
-		unlock();
-		return 0;
+	recordLateness(lane, millis() - dispatch.dueAtMs);
+	if constexpr (std::is_same_v<Dispatch, TimedDispatch>) {
+		invokeTimerCallback(lane.callbacks[dispatch.index]);
+	} else {
+		dispatch.nextMs = invokeTimerCallback(lane.callbacks[dispatch.index], dispatch.arg);
 	}
 
-	resetItem(*slot, Type::Min);
-	slot->active = true;
-	slot->id = nextIdLocked();
-	slot->status = ESPTimerStatus::Running;
-	slot->createdMs = millis();
-	slot->endAtMs = slot->createdMs + totalMs;
-	slot->lastTickMs = slot->createdMs;
-	slot->cb = std::move(cb);
+	const uint32_t callbackBudgetUs = tunables_.callbackBudgetUs.load(std::memory_order_relaxed);
+	if (callbackBudgetUs > 0 && cfg_.onCallbackOverrun) {
+		const uint32_t elapsedUs = micros() - startUs;
+		if (elapsedUs > callbackBudgetUs) {
+			const uint32_t id =
+			    makeId(laneType<Item>(), lane.shard, item.generation(), dispatch.index);
+			cfg_.onCallbackOverrun(id, elapsedUs);
+		}
+	}
+}
 
-	const uint32_t id = slot->id;
-	unlock();
-	return id;
+// Never blocks: the lane lock is held and the scan must not wait on a consumer. The final
+// event of a timer frees its slot before it is posted, so a consumer that wakes on it already
+// sees the ID as invalid.
+template <typename Item, typename Dispatch>
+void ESPTimer::postEventLocked(
+    Lane<Item, Dispatch> &lane,
+    uint8_t shard,
+    size_t index,
+    uint32_t value,
+    bool last
+) {
+	const EventTarget target = lane.events[index];
+	const uint32_t id = makeId(laneType<Item>(), shard, lane.items[index].generation(), index);
+	const ESPTimerEvent event{id, target.tag, value};
+	wakeWaiterLocked(lane, index, kWaitFiredBit);
+	if (last) {
+		releaseSlotLocked(lane, index);
+	}
+	bool posted = false;
+	switch (target.sink.kind) {
+	case ESPTimerEventSink::Kind::Queue:
+		posted = xQueueSend(static_cast<QueueHandle_t>(target.sink.handle), &event, 0) == pdTRUE;
+		break;
+	case ESPTimerEventSink::Kind::RingBuffer:
+		posted = xRingbufferSend(
+		             static_cast<RingbufHandle_t>(target.sink.handle),
+		             &event,
+		             sizeof(event),
+		             0
+		         ) == pdTRUE;
+		break;
+	case ESPTimerEventSink::Kind::Notification:
+		posted = xTaskNotify(
+		             static_cast<TaskHandle_t>(target.sink.handle),
+		             target.sink.bits,
+		             eSetBits
+		         ) == pdPASS;
+		break;
+	case ESPTimerEventSink::Kind::None:
+		posted = true; // sleepFor() slots only resume their coroutine
+		break;
+	}
+	if (!posted) {
+		droppedEvents_.fetch_add(1, std::memory_order_relaxed);
+	}
 }
 
-ESPTimerStatus ESPTimer::togglePause(Type type, uint32_t id) {
-	if (!lock()) {
-		return ESPTimerStatus::Invalid;
+// The waiting task leaves waitFor() only after this ran or after withdrawing under the lane
+// lock, so its handle is valid here. Suspended coroutines move to the lane's resumable list.
+template <typename Item, typename Dispatch>
+void ESPTimer::wakeWaiterLocked(Lane<Item, Dispatch> &lane, size_t index, uint32_t bit) {
+	Item &item = lane.items[index];
+	if (!item.hasWaiter()) {
+		return;
 	}
-	if (lifecycleState_.load(std::memory_order_acquire) != LifecycleState::Initialized) {
-		unlock();
-		return ESPTimerStatus::Invalid;
+	Waiters &waiters = lane.waiters[index];
+	if (waiters.task) {
+		xTaskNotify(waiters.task, bit, eSetBits);
+	}
+	while (ESPTimerResumeNode *node = waiters.coroutines) {
+		waiters.coroutines = node->next;
+		node->fired = bit == kWaitFiredBit;
+		node->next = lane.resumable;
+		lane.resumable = node;
 	}
+	waiters = Waiters{};
+	item.setWaiter(false);
+}
 
-	ESPTimerStatus newStatus = ESPTimerStatus::Invalid;
-	auto toggle = [&](auto &vec) {
-		if (auto *item = findItemById(vec, id)) {
-			if (item->status == ESPTimerStatus::Running) {
-				item->status = ESPTimerStatus::Paused;
-				newStatus = ESPTimerStatus::Paused;
-				return;
-			}
-			if (item->status == ESPTimerStatus::Paused) {
-				item->status = ESPTimerStatus::Running;
-				if constexpr (std::is_same_v<std::decay_t<decltype(*item)>, IntervalItem>) {
-					item->lastFireMs = millis();
-				} else if constexpr (!std::is_same_v<std::decay_t<decltype(*item)>, TimeoutItem>) {
-					item->lastTickMs = millis();
-				}
-				newStatus = ESPTimerStatus::Running;
-			}
+template <typename Item, typename Dispatch>
+bool ESPTimer::addWaiterLocked(Lane<Item, Dispatch> &lane, uint32_t id, TaskHandle_t task) {
+	size_t index = 0;
+	Item *item = findItemById(lane, id, index);
+	if (!item || item->status() == ESPTimerStatus::Stopped || lane.waiters[index].task) {
+		return false;
+	}
+	lane.waiters[index].task = task;
+	item->setWaiter(true);
+	return true;
+}
+
+template <typename Item, typename Dispatch>
+bool ESPTimer::removeWaiterLocked(Lane<Item, Dispatch> &lane, uint32_t id, TaskHandle_t task) {
+	size_t index = 0;
+	Item *item = findItemById(lane, id, index);
+	if (!item || !item->hasWaiter() || lane.waiters[index].task != task) {
+		return false;
+	}
+	lane.waiters[index].task = nullptr;
+	item->setWaiter(lane.waiters[index].coroutines != nullptr);
+	return true;
+}
+
+template <typename Item, typename Dispatch>
+bool ESPTimer::addCoroutineLocked(
+    Lane<Item, Dispatch> &lane,
+    uint32_t id,
+    ESPTimerResumeNode &node
+) {
+	size_t index = 0;
+	Item *item = findItemById(lane, id, index);
+	if (!item || item->status() == ESPTimerStatus::Stopped) {
+		return false;
+	}
+	node.next = lane.waiters[index].coroutines;
+	lane.waiters[index].coroutines = &node;
+	item->setWaiter(true);
+	return true;
+}
+
+template <typename Item, typename Dispatch>
+ESPTimerResumeNode *ESPTimer::takeResumableLocked(Lane<Item, Dispatch> &lane) {
+	ESPTimerResumeNode *ready = lane.resumable;
+	lane.resumable = nullptr;
+	return ready;
+}
+
+// A resumed coroutine may finish and free the frame that holds its node, so the successor is
+// read first.
+void ESPTimer::resumeCoroutines(ESPTimerResumeNode *node) {
+	while (node) {
+		ESPTimerResumeNode *next = node->next;
+		node->resume(node->frame);
+		node = next;
+	}
+}
+
+template <typename Item, typename Dispatch>
+void ESPTimer::runJob(ESPTimer &timer, void *lane, uint16_t entry) {
+	auto &owner = *static_cast<Lane<Item, Dispatch> *>(lane);
+	timer.invokeDispatch(owner, owner.dispatch[entry]);
+	if (owner.pendingJobs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+		xSemaphoreGive(owner.batchDone);
+	}
+}
+
+// Queues the staged batch on this core's deque, wakes the other core's executor to steal from
+// it and works through the deque until every job of the batch has run somewhere. Returns
+// false when the batch should simply run inline.
+template <typename Item, typename Dispatch>
+bool ESPTimer::stealableBatch(Lane<Item, Dispatch> &lane) {
+	const uint8_t count = executorCount_.load(std::memory_order_acquire);
+	const size_t staged = lane.dispatch.size();
+	if (count < 2 || staged < 2) {
+		return false;
+	}
+
+	const uint8_t home = static_cast<uint8_t>(xPortGetCoreID()) % count;
+	Executor &local = executors_[home];
+	Executor &remote = executors_[home ^ 1];
+	if (!local.lock()) {
+		return false;
+	}
+	lane.pendingJobs.store(static_cast<uint16_t>(staged + 1), std::memory_order_relaxed);
+	// Queued last entry first, so this core pops the batch in order and thieves take its tail.
+	size_t queued = 0;
+	while (queued < staged) {
+		const auto entry = static_cast<uint16_t>(staged - 1 - queued);
+		const CallbackJob job{&runJob<Item, Dispatch>, &lane, entry};
+		if (!local.jobs.pushBack(job)) {
+			break;
 		}
-	};
+		++queued;
+	}
+	lane.pendingJobs.fetch_sub(static_cast<uint16_t>(staged - queued), std::memory_order_relaxed);
+	local.unlock();
+	if (queued == 0) {
+		lane.pendingJobs.store(0, std::memory_order_relaxed);
+		return false;
+	}
+
+	wakeExecutor(remote);
+	for (size_t i = 0; i < staged - queued; ++i) {
+		invokeDispatch(lane, lane.dispatch[i]);
+	}
+
+	CallbackJob job;
+	while (lane.pendingJobs.load(std::memory_order_acquire) > 1 && takeJob(local, remote, job)) {
+		job.run(*this, job.lane, job.entry);
+	}
+	if (lane.pendingJobs.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+		xSemaphoreTake(lane.batchDone, portMAX_DELAY);
+	}
+	return true;
+}
+
+bool ESPTimer::configureStorageLocked() {
+	const uint8_t count = shardCount_.load(std::memory_order_relaxed);
+	const bool withInbox = count > 1;
+	bool configured = true;
+	for (uint8_t i = 0; i < count && configured; ++i) {
+		Shard &shard = shards_[i];
+		configured = configureLane(shard.timeouts, cfg_.maxTimeouts, withInbox) &&
+		             configureLane(shard.intervals, cfg_.maxIntervals, withInbox) &&
+		             configureLane(shard.counters, cfg_.maxCounters, withInbox);
+	}
+
+	for (uint8_t i = 0; i < executorCount_.load(std::memory_order_relaxed) && configured; ++i) {
+		TimerDeque<CallbackJob> jobs(dispatchRegion_);
+		configured = jobs.configure(jobCapacity()) && executors_[i].lock();
+		if (configured) {
+			executors_[i].jobs.swap(jobs);
+			executors_[i].unlock();
+		}
+	}
+	if (!configured) {
+		releaseStorageLocked();
+	}
+	return configured;
+}
+
+// Every staged callback occupies one slot, so a deque never holds more jobs than there are
+// slots across all active lanes. Counted from the lanes, which only change under `mutex_`.
+size_t ESPTimer::jobCapacity() const {
+	size_t capacity = 0;
+	for (uint8_t i = 0; i < shardCount_.load(std::memory_order_relaxed); ++i) {
+		const Shard &shard = shards_[i];
+		capacity += shard.timeouts.slots.capacity() + shard.intervals.slots.capacity() +
+		            shard.counters.slots.capacity();
+	}
+	return capacity;
+}
+
+// Resizes the deques in place after the lanes changed size. Jobs of a batch in flight move
+// along, so the executors never have to stop; a deque that still holds more jobs than it may
+// shrink to keeps its size. Returns false only when a deque could not grow.
+bool ESPTimer::resizeJobDequesLocked() {
+	const size_t capacity = jobCapacity();
+	bool resized = true;
+	for (uint8_t i = 0; i < executorCount_.load(std::memory_order_relaxed); ++i) {
+		Executor &executor = executors_[i];
+		if (!executor.lock()) {
+			resized = false;
+			continue;
+		}
+		const bool growing = capacity > executor.jobs.capacity();
+		if (capacity != executor.jobs.capacity() && !executor.jobs.resize(capacity) && growing) {
+			resized = false;
+		}
+		executor.unlock();
+	}
+	return resized;
+}
 
+void ESPTimer::releaseStorageLocked() {
+	forEachLane([this](auto &lane) { releaseLane(lane); });
+	for (Executor &executor : executors_) {
+		TimerDeque<CallbackJob> jobs(executor.jobs.region());
+		if (executor.lock()) {
+			executor.jobs.swap(jobs);
+			executor.unlock();
+		}
+	}
+}
+
+bool ESPTimer::tryCreateWorkerLocked(
+    TaskFunction_t fn,
+    const char *name,
+    uint16_t stack,
+    UBaseType_t prio,
+    int8_t core,
+    void *arg,
+    TaskHandle_t &handle,
+    EventBits_t exitBit
+) {
+	handle = nullptr;
+	xEventGroupClearBits(exited_, exitBit);
+	const BaseType_t coreId = core < 0 ? tskNO_AFFINITY : static_cast<BaseType_t>(core);
+	const bool created = xTaskCreatePinnedToCore(
+	                         fn,
+	                         name ? name : "ESPTimerTask",
+	                         stack,
+	                         arg,
+	                         prio,
+	                         &handle,
+	                         coreId
+	                     ) == pdPASS &&
+	                     handle != nullptr;
+	if (!created) {
+		xEventGroupSetBits(exited_, exitBit);
+	}
+	return created;
+}
+
+bool ESPTimer::createShardWorkersLocked(Shard &shard) {
+	return createWorkerLocked(shard, Type::Timeout, cfg_) &&
+	       createWorkerLocked(shard, Type::Interval, cfg_) &&
+	       createWorkerLocked(shard, Type::Counter, cfg_);
+}
+
+// In sharded mode workers are pinned to their shard's core and the per-type core settings are
+// ignored.
+bool ESPTimer::createWorkerLocked(Shard &shard, Type type, const ESPTimerConfig &cfg) {
+	const int8_t pinnedCore =
+	    shardCount_.load(std::memory_order_relaxed) > 1 ? static_cast<int8_t>(shardIndex(shard))
+	                                                    : -1;
+	TaskHandle_t &handle = workerHandle(shard, type);
+	const EventBits_t exitBit = workerBit(shard, type);
 	switch (type) {
 	case Type::Timeout:
-		toggle(timeouts_);
-		break;
+		return tryCreateWorkerLocked(
+		    &ESPTimer::timeoutTaskTrampoline,
+		    "ESPTmrTimeout",
+		    cfg.stackSizeTimeout,
+		    cfg.priorityTimeout,
+		    pinnedCore < 0 ? cfg.coreTimeout : pinnedCore,
+		    &shard,
+		    handle,
+		    exitBit
+		);
 	case Type::Interval:
-		toggle(intervals_);
-		break;
-	case Type::Sec:
-		toggle(secs_);
-		break;
-	case Type::Ms:
-		toggle(mss_);
-		break;
-	case Type::Min:
-		toggle(mins_);
+		return tryCreateWorkerLocked(
+		    &ESPTimer::intervalTaskTrampoline,
+		    "ESPTmrInterval",
+		    cfg.stackSizeInterval,
+		    cfg.priorityInterval,
+		    pinnedCore < 0 ? cfg.coreInterval : pinnedCore,
+		    &shard,
+		    handle,
+		    exitBit
+		);
+	case Type::Counter:
+		return tryCreateWorkerLocked(
+		    &ESPTimer::counterTaskTrampoline,
+		    "ESPTmrCounter",
+		    cfg.stackSizeCounter,
+		    cfg.priorityCounter,
+		    pinnedCore < 0 ? cfg.coreCounter : pinnedCore,
+		    &shard,
+		    handle,
+		    exitBit
+		);
+	}
+	return false;
+}
+
+bool ESPTimer::createExecutorsLocked() {
+	bool created = true;
+	for (uint8_t i = 0; i < executorCount_.load(std::memory_order_relaxed) && created; ++i) {
+		created = tryCreateWorkerLocked(
+		    &ESPTimer::executorTaskTrampoline,
+		    "ESPTmrExecutor",
+		    cfg_.stackSizeExecutor,
+		    cfg_.priorityExecutor,
+		    static_cast<int8_t>(i),
+		    &executors_[i],
+		    executors_[i].handle,
+		    executorBit(executors_[i])
+		);
+	}
+	return created;
+}
+
+EventBits_t ESPTimer::workerBit(const Shard &shard, Type type) const {
+	return 1u << (shardIndex(shard) * 3 + static_cast<uint8_t>(type));
+}
+
+EventBits_t ESPTimer::executorBit(const Executor &executor) const {
+	return 1u << (kMaxShards * 3 + (&executor - executors_));
+}
+
+// Waits until every worker in `bits` has parked in parkWorker(), then deletes those tasks and
+// clears their handles. A worker still running when `timeout` expires may be inside a callback
+// or hold a lane lock, so it is left alone and the join reports false; its bit stays clear for
+// the next join. Handles are cleared under the lock their notifiers hold: the counter lane's
+// for counter workers, the executor's own for executors. The cyclic task is reaped by
+// stopCyclic().
+bool ESPTimer::joinWorkers(EventBits_t bits, TickType_t timeout) {
+	if (bits == 0) {
+		return true;
+	}
+	const EventBits_t exited = xEventGroupWaitBits(exited_, bits, pdFALSE, pdTRUE, timeout) & bits;
+	auto reap = [&](EventBits_t bit, TaskHandle_t &handle) {
+		if ((exited & bit) != 0 && handle) {
+			vTaskDelete(handle);
+			handle = nullptr;
+		}
+	};
+	for (Shard &shard : shards_) {
+		reap(workerBit(shard, Type::Timeout), shard.hTimeout);
+		reap(workerBit(shard, Type::Interval), shard.hInterval);
+		if ((exited & workerBit(shard, Type::Counter)) != 0 && shard.counters.lock()) {
+			reap(workerBit(shard, Type::Counter), shard.hCounter);
+			shard.counters.unlock();
+		}
+	}
+	for (Executor &executor : executors_) {
+		if ((exited & executorBit(executor)) != 0 && executor.lock()) {
+			reap(executorBit(executor), executor.handle);
+			executor.unlock();
+		}
+	}
+	return exited == bits;
+}
+
+TaskHandle_t &ESPTimer::workerHandle(Shard &shard, Type type) {
+	switch (type) {
+	case Type::Interval:
+		return shard.hInterval;
+	case Type::Counter:
+		return shard.hCounter;
+	case Type::Timeout:
 		break;
 	}
+	return shard.hTimeout;
+}
 
-	unlock();
-	return newStatus;
+// A retire request is taken with one atomic step, so reconfigure() can withdraw any request
+// the worker has not taken yet and knows the others lead straight to parkWorker().
+bool ESPTimer::workerActive(Shard &shard, Type type) {
+	const uint8_t bit = static_cast<uint8_t>(1u << static_cast<uint8_t>(type));
+	return running_.load(std::memory_order_acquire) &&
+	       ((shard.retiring.load(std::memory_order_acquire) & bit) == 0 ||
+	        (shard.retiring.fetch_and(static_cast<uint8_t>(~bit), std::memory_order_acq_rel) &
+	         bit) == 0);
 }
 
-bool ESPTimer::pauseItem(Type type, uint32_t id) {
-	if (!lock()) {
-		return false;
+// Last step of every worker: signals `exitBit` and suspends the calling task until the joining
+// task deletes it. Nothing here takes a lock, so a join never waits on a lock held by a worker
+// on its way out, and the handle stays valid for late notifications until joinWorkers() clears
+// it. The joining task frees the storage the worker used as soon as it sees the bit.
+void ESPTimer::parkWorker(EventBits_t exitBit) {
+	xEventGroupSetBits(exited_, exitBit);
+	for (;;) {
+		vTaskSuspend(nullptr);
 	}
-	if (lifecycleState_.load(std::memory_order_acquire) != LifecycleState::Initialized) {
+}
+
+// Called with the shard's counter lane locked. joinWorkers() only clears the counter handle
+// under that lock, so the task is alive for the notification.
+void ESPTimer::wakeCounterWorkerLocked(Shard &shard) {
+	if (shard.hCounter) {
+		xTaskNotifyGive(shard.hCounter);
+	}
+}
+
+void ESPTimer::init(const ESPTimerConfig &cfg) {
+	if (!exited_ || !lock()) {
+		return;
+	}
+
+	if (lifecycleState_.load(std::memory_order_acquire) != LifecycleState::Uninitialized) {
 		unlock();
-		return false;
+		return;
+	}
+
+	lifecycleState_.store(LifecycleState::Initializing, std::memory_order_release);
+	cfg_ = normalizeConfig(cfg);
+	tunables_.store(cfg_);
+	slotRegion_ = resolveRegion(cfg_.slotMemory);
+	callbackRegion_ = resolveRegion(cfg_.callbackMemory);
+	dispatchRegion_ = resolveRegion(cfg_.dispatchMemory);
+	const uint8_t shardCount = cfg_.shardPerCore && kCoreCount > 1 ? kMaxShards : 1;
+	shardCount_.store(shardCount, std::memory_order_relaxed);
+	droppedEvents_.store(0, std::memory_order_relaxed);
+	resetLatenessStats();
+	forEachLane([](auto &lane) {
+		LaneLoad &load = lane.load;
+		for (auto *counter : {&load.peakSlots,
+		                      &load.occupancyAlarms,
+		                      &load.latenessAlarms,
+		                      &load.rejected,
+		                      &load.evicted,
+		                      &load.overflowed}) {
+			counter->store(0, std::memory_order_relaxed);
+		}
+		load.crowded.store(false, std::memory_order_relaxed);
+		load.late.store(false, std::memory_order_relaxed);
+	});
+	const uint8_t executorCount = cfg_.stealCallbacks && kCoreCount > 1 ? kMaxShards : 0;
+	executorCount_.store(executorCount, std::memory_order_relaxed);
+
+	if (!configureStorageLocked()) {
+		shardCount_.store(1, std::memory_order_relaxed);
+		executorCount_.store(0, std::memory_order_relaxed);
+		lifecycleState_.store(LifecycleState::Uninitialized, std::memory_order_release);
+		unlock();
+		return;
 	}
 
-	bool changed = false;
-	auto pauseFn = [&](auto &vec) {
-		if (auto *item = findItemById(vec, id)) {
-			if (item->status == ESPTimerStatus::Running) {
-				item->status = ESPTimerStatus::Paused;
-				changed = true;
+	running_.store(true, std::memory_order_release);
+
+	bool created = true;
+	for (uint8_t i = 0; i < shardCount && created; ++i) {
+		created = createShardWorkersLocked(shards_[i]);
+	}
+	created = created && createExecutorsLocked();
+
+	if (!created) {
+		running_.store(false, std::memory_order_release);
+		lifecycleState_.store(LifecycleState::Deinitializing, std::memory_order_release);
+		unlock();
+
+		for (Shard &shard : shards_) {
+			if (shard.counters.lock()) {
+				wakeCounterWorkerLocked(shard);
+				shard.counters.unlock();
 			}
 		}
-	};
+		for (Executor &executor : executors_) {
+			wakeExecutor(executor);
+		}
+		// No timer exists yet, so every worker is on its way out.
+		joinWorkers(kLaneExitBits | kExecutorExitBits, portMAX_DELAY);
 
-	switch (type) {
-	case Type::Timeout:
-		pauseFn(timeouts_);
-		break;
-	case Type::Interval:
-		pauseFn(intervals_);
-		break;
-	case Type::Sec:
-		pauseFn(secs_);
-		break;
-	case Type::Ms:
-		pauseFn(mss_);
-		break;
-	case Type::Min:
-		pauseFn(mins_);
-		break;
+		if (lock()) {
+			releaseStorageLocked();
+			shardCount_.store(1, std::memory_order_relaxed);
+			executorCount_.store(0, std::memory_order_relaxed);
+			lifecycleState_.store(LifecycleState::Uninitialized, std::memory_order_release);
+			unlock();
+		}
+		return;
 	}
 
+	lifecycleState_.store(LifecycleState::Initialized, std::memory_order_release);
 	unlock();
-	return changed;
 }
 
-bool ESPTimer::resumeItem(Type type, uint32_t id) {
+void ESPTimer::deinit() {
+	deinit(pdMS_TO_TICKS(kJoinTimeoutMs));
+}
+
+// Every worker is told to stop at once and joined through `exited_`, so the whole shutdown
+// takes as long as the slowest callback in flight rather than a poll interval per task. A call
+// that runs out of time leaves the instance deinitializing with `shutdownPending_` set, and the
+// next call resumes the join where it stopped.
+bool ESPTimer::deinit(TickType_t timeout) {
 	if (!lock()) {
 		return false;
 	}
-	if (lifecycleState_.load(std::memory_order_acquire) != LifecycleState::Initialized) {
+
+	const LifecycleState state = lifecycleState_.load(std::memory_order_acquire);
+	if (state == LifecycleState::Uninitialized ||
+	    (state == LifecycleState::Deinitializing && !shutdownPending_)) {
 		unlock();
-		return false;
+		return true;
 	}
 
-	bool changed = false;
-	auto resumeFn = [&](auto &vec) {
-		if (auto *item = findItemById(vec, id)) {
-			if (item->status == ESPTimerStatus::Paused) {
-				item->status = ESPTimerStatus::Running;
-				if constexpr (std::is_same_v<std::decay_t<decltype(*item)>, IntervalItem>) {
-					item->lastFireMs = millis();
-				} else if constexpr (!std::is_same_v<std::decay_t<decltype(*item)>, TimeoutItem>) {
-					item->lastTickMs = millis();
-				}
-				changed = true;
-			}
-		}
+	// Sequentially consistent so lock-free users (status reads, cross-core posts) either see
+	// this transition or are counted. They are drained before the workers stop, so a post that
+	// saw the instance initialized can still notify its worker.
+	const bool resumed = shutdownPending_;
+	shutdownPending_ = false;
+	lifecycleState_.store(LifecycleState::Deinitializing);
+	unlock();
+	if (!resumed) {
+		waitForLockFreeUsers();
+	}
+	const TickType_t start = xTaskGetTickCount();
+	auto remaining = [&]() {
+		const TickType_t spent = xTaskGetTickCount() - start;
+		return spent < timeout ? timeout - spent : 0;
 	};
+	bool drained = stopCyclic(timeout);
 
-	switch (type) {
-	case Type::Timeout:
-		resumeFn(timeouts_);
-		break;
-	case Type::Interval:
-		resumeFn(intervals_);
-		break;
-	case Type::Sec:
-		resumeFn(secs_);
-		break;
-	case Type::Ms:
-		resumeFn(mss_);
-		break;
-	case Type::Min:
-		resumeFn(mins_);
-		break;
+	running_.store(false, std::memory_order_release);
+	for (Shard &shard : shards_) {
+		if (shard.counters.lock()) {
+			wakeCounterWorkerLocked(shard);
+			shard.counters.unlock();
+		}
+	}
+	for (Executor &executor : executors_) {
+		wakeExecutor(executor);
+	}
+	drained = joinWorkers(kLaneExitBits, remaining()) && drained;
+	// Lane workers finish their own batches, so the executors can go last.
+	drained = joinWorkers(kExecutorExitBits, remaining()) && drained;
+
+	if (!lock()) {
+		return false;
+	}
+	if (!drained) {
+		// A worker still inside a callback may touch its lane at any time, so nothing is freed.
+		shutdownPending_ = true;
+		unlock();
+		return false;
 	}
 
+	releaseStorageLocked();
+	cfg_ = ESPTimerConfig{};
+	slotRegion_ = ESPTimerMemoryRegion::Default;
+	callbackRegion_ = ESPTimerMemoryRegion::Default;
+	dispatchRegion_ = ESPTimerMemoryRegion::Default;
+	shardCount_.store(1, std::memory_order_relaxed);
+	executorCount_.store(0, std::memory_order_relaxed);
+	lifecycleState_.store(LifecycleState::Uninitialized, std::memory_order_release);
 	unlock();
-	return changed;
+	return drained;
 }
 
-bool ESPTimer::clearItem(Type type, uint32_t id) {
+// Lanes are migrated first, each checked against its new capacity under its own lock, and the
+// settings below are only committed once every lane has moved. Only these fields are taken
+// from `cfg`: the hooks may be running on a worker right now, so they stay as set at init().
+bool ESPTimer::reconfigure(const ESPTimerConfig &cfg) {
 	if (!lock()) {
 		return false;
 	}
@@ -673,569 +1568,1590 @@ bool ESPTimer::clearItem(Type type, uint32_t id) {
 		return false;
 	}
 
-	bool removed = false;
-	auto clearFn = [&](auto &vec) {
-		if (auto *item = findItemById(vec, id)) {
-			removed = true;
-			item->status = ESPTimerStatus::Stopped;
-			if (!item->executing) {
-				resetItem(*item, type);
+	const ESPTimerConfig next = normalizeConfig(cfg);
+	bool accepted = next.shardPerCore == cfg_.shardPerCore &&
+	                next.stealCallbacks == cfg_.stealCallbacks &&
+	                next.usePSRAMBuffers == cfg_.usePSRAMBuffers &&
+	                next.slotMemory == cfg_.slotMemory &&
+	                next.callbackMemory == cfg_.callbackMemory &&
+	                next.dispatchMemory == cfg_.dispatchMemory;
+	const uint8_t count = shardCount_.load(std::memory_order_relaxed);
+	auto capacity = [&next](uint16_t regularSlots) {
+		return laneCapacity(next, laneLimit(next, regularSlots));
+	};
+	// Early rejection only: resizeLane() repeats the check under the lane lock.
+	for (uint8_t i = 0; i < count && accepted; ++i) {
+		Shard &shard = shards_[i];
+		accepted = laneFits(shard.timeouts, capacity(next.maxTimeouts)) &&
+		           laneFits(shard.intervals, capacity(next.maxIntervals)) &&
+		           laneFits(shard.counters, capacity(next.maxCounters));
+	}
+	if (!accepted) {
+		unlock();
+		return false;
+	}
+
+	const TickType_t timeout = pdMS_TO_TICKS(kJoinTimeoutMs);
+	auto migrate = [&](const ESPTimerConfig &target, bool untilFailure) {
+		bool resized = true;
+		auto resize = [&](auto &lane, uint16_t regularSlots) {
+			if ((resized || !untilFailure) && !laneMatches(lane, target, regularSlots)) {
+				resized = resizeLane(lane, target, regularSlots, timeout) && resized;
 			}
+		};
+		for (uint8_t i = 0; i < count; ++i) {
+			Shard &shard = shards_[i];
+			resize(shard.timeouts, target.maxTimeouts);
+			resize(shard.intervals, target.maxIntervals);
+			resize(shard.counters, target.maxCounters);
 		}
+		return resized;
 	};
-
-	switch (type) {
-	case Type::Timeout:
-		clearFn(timeouts_);
-		break;
-	case Type::Interval:
-		clearFn(intervals_);
-		break;
-	case Type::Sec:
-		clearFn(secs_);
-		break;
-	case Type::Ms:
-		clearFn(mss_);
-		break;
-	case Type::Min:
-		clearFn(mins_);
-		break;
+	if (!migrate(next, true)) {
+		// Lanes already migrated move back. One that cannot, because a timer took a slot above
+		// its old capacity meanwhile, keeps the new layout and is migrated by the next call.
+		migrate(cfg_, false);
+		resizeJobDequesLocked();
+		unlock();
+		return false;
 	}
 
+	const ESPTimerConfig previous = cfg_;
+	cfg_.stackSizeTimeout = next.stackSizeTimeout;
+	cfg_.stackSizeInterval = next.stackSizeInterval;
+	cfg_.stackSizeCounter = next.stackSizeCounter;
+	cfg_.priorityTimeout = next.priorityTimeout;
+	cfg_.priorityInterval = next.priorityInterval;
+	cfg_.priorityCounter = next.priorityCounter;
+	cfg_.coreTimeout = next.coreTimeout;
+	cfg_.coreInterval = next.coreInterval;
+	cfg_.coreCounter = next.coreCounter;
+	cfg_.staggerIntervals = next.staggerIntervals;
+	cfg_.orderDispatch = next.orderDispatch;
+	cfg_.laneBudgetUs = next.laneBudgetUs;
+	cfg_.callbackBudgetUs = next.callbackBudgetUs;
+	cfg_.admission = next.admission;
+	cfg_.overflowSlots = next.overflowSlots;
+	cfg_.occupancyHighWaterPct = next.occupancyHighWaterPct;
+	cfg_.latenessHighWaterMs = next.latenessHighWaterMs;
+	cfg_.stackSizeExecutor = next.stackSizeExecutor;
+	cfg_.priorityExecutor = next.priorityExecutor;
+	cfg_.maxTimeouts = next.maxTimeouts;
+	cfg_.maxIntervals = next.maxIntervals;
+	cfg_.maxCounters = next.maxCounters;
+	cfg_.elasticChunkSlots = next.elasticChunkSlots;
+	cfg_.elasticMaxSlots = next.elasticMaxSlots;
+	cfg_.elasticReclaimMs = next.elasticReclaimMs;
+	tunables_.store(cfg_);
+
+	bool applied = resizeJobDequesLocked();
+	applied = restartWorkersLocked(previous) && applied;
 	unlock();
-	return removed;
+	return applied;
 }
 
-ESPTimerStatus ESPTimer::getItemStatus(Type type, uint32_t id) {
-	if (!lock()) {
-		return ESPTimerStatus::Invalid;
+// Retires every worker whose stack size or core changed, joins all of them once they have
+// finished their current pass and starts their replacements, falling back to the previous
+// settings when that fails. The other workers get their new priority in place. While the
+// counter worker is replaced, cross-core posts take the lane lock, because they notify it
+// without holding it. A worker still inside a callback after the join timeout is asked to stay;
+// its type then keeps the previous stack size and core on every shard, so `cfg_` never
+// describes a worker that does not exist.
+bool ESPTimer::restartWorkersLocked(const ESPTimerConfig &previous) {
+	const uint8_t count = shardCount_.load(std::memory_order_relaxed);
+	const bool pinned = count > 1;
+	auto replaced = [&](Type type) {
+		switch (type) {
+		case Type::Timeout:
+			return previous.stackSizeTimeout != cfg_.stackSizeTimeout ||
+			       (!pinned && previous.coreTimeout != cfg_.coreTimeout);
+		case Type::Interval:
+			return previous.stackSizeInterval != cfg_.stackSizeInterval ||
+			       (!pinned && previous.coreInterval != cfg_.coreInterval);
+		case Type::Counter:
+			return previous.stackSizeCounter != cfg_.stackSizeCounter ||
+			       (!pinned && previous.coreCounter != cfg_.coreCounter);
+		}
+		return false;
+	};
+	auto priority = [&](Type type) {
+		switch (type) {
+		case Type::Interval:
+			return cfg_.priorityInterval;
+		case Type::Counter:
+			return cfg_.priorityCounter;
+		case Type::Timeout:
+			break;
+		}
+		return cfg_.priorityTimeout;
+	};
+	const Type types[] = {Type::Timeout, Type::Interval, Type::Counter};
+	uint8_t retired = 0;
+	for (const Type type : types) {
+		if (replaced(type)) {
+			retired |= static_cast<uint8_t>(1u << static_cast<uint8_t>(type));
+		}
+	}
+	const uint8_t counterBit = 1u << static_cast<uint8_t>(Type::Counter);
+	const bool executorsReplaced = previous.stackSizeExecutor != cfg_.stackSizeExecutor;
+	const uint8_t executorCount = executorCount_.load(std::memory_order_relaxed);
+
+	if (retired & counterBit) {
+		for (uint8_t i = 0; i < count; ++i) {
+			shards_[i].counters.exclusive.store(true);
+		}
+		waitForLockFreeUsers();
+	}
+	EventBits_t joined = 0;
+	for (uint8_t i = 0; i < count && retired != 0; ++i) {
+		Shard &shard = shards_[i];
+		for (const Type type : types) {
+			if (retired & (1u << static_cast<uint8_t>(type))) {
+				joined |= workerBit(shard, type);
+			}
+		}
+		shard.retiring.store(retired, std::memory_order_release);
+		if ((retired & counterBit) && shard.counters.lock()) {
+			wakeCounterWorkerLocked(shard);
+			shard.counters.unlock();
+		}
+	}
+	for (uint8_t i = 0; i < executorCount && executorsReplaced; ++i) {
+		joined |= executorBit(executors_[i]);
+		executors_[i].retiring.store(true, std::memory_order_release);
+		wakeExecutor(executors_[i]);
+	}
+
+	// Workers still busy at the timeout are asked to stay. Those that took their request before
+	// it was withdrawn are on their way out and park without taking a lock.
+	uint8_t kept = 0;
+	bool executorsKept = false;
+	if (!joinWorkers(joined, pdMS_TO_TICKS(kJoinTimeoutMs))) {
+		const EventBits_t busy = joined & ~xEventGroupGetBits(exited_);
+		for (uint8_t i = 0; i < count; ++i) {
+			Shard &shard = shards_[i];
+			for (const Type type : types) {
+				const uint8_t bit = static_cast<uint8_t>(1u << static_cast<uint8_t>(type));
+				if ((busy & workerBit(shard, type)) != 0 &&
+				    (shard.retiring.fetch_and(static_cast<uint8_t>(~bit)) & bit) != 0) {
+					kept |= bit;
+					joined &= ~workerBit(shard, type);
+				}
+			}
+		}
+		for (uint8_t i = 0; i < executorCount; ++i) {
+			Executor &executor = executors_[i];
+			if ((busy & executorBit(executor)) != 0 && executor.retiring.exchange(false)) {
+				executorsKept = true;
+				joined &= ~executorBit(executor);
+			}
+		}
+		joinWorkers(joined, portMAX_DELAY);
+	}
+	if (kept & (1u << static_cast<uint8_t>(Type::Timeout))) {
+		cfg_.stackSizeTimeout = previous.stackSizeTimeout;
+		cfg_.coreTimeout = previous.coreTimeout;
+	}
+	if (kept & (1u << static_cast<uint8_t>(Type::Interval))) {
+		cfg_.stackSizeInterval = previous.stackSizeInterval;
+		cfg_.coreInterval = previous.coreInterval;
+	}
+	if (kept & counterBit) {
+		cfg_.stackSizeCounter = previous.stackSizeCounter;
+		cfg_.coreCounter = previous.coreCounter;
+	}
+	if (executorsKept) {
+		cfg_.stackSizeExecutor = previous.stackSizeExecutor;
+	}
+
+	bool restarted = kept == 0 && !executorsKept;
+	for (uint8_t i = 0; i < count; ++i) {
+		Shard &shard = shards_[i];
+		for (const Type type : types) {
+			TaskHandle_t &handle = workerHandle(shard, type);
+			// A worker that stayed still has its handle; joined ones were cleared.
+			if ((retired & (1u << static_cast<uint8_t>(type))) == 0 || handle) {
+				if (handle && uxTaskPriorityGet(handle) != priority(type)) {
+					vTaskPrioritySet(handle, priority(type));
+				}
+				continue;
+			}
+			if (!createWorkerLocked(shard, type, cfg_)) {
+				restarted = false;
+				createWorkerLocked(shard, type, previous);
+			}
+		}
+		shard.counters.exclusive.store(false);
+	}
+
+	for (uint8_t i = 0; i < executorCount; ++i) {
+		Executor &executor = executors_[i];
+		if (!executorsReplaced || executor.handle) {
+			if (executor.handle && uxTaskPriorityGet(executor.handle) != cfg_.priorityExecutor) {
+				vTaskPrioritySet(executor.handle, cfg_.priorityExecutor);
+			}
+			continue;
+		}
+		for (const uint16_t stack : {cfg_.stackSizeExecutor, previous.stackSizeExecutor}) {
+			if (tryCreateWorkerLocked(
+			        &ESPTimer::executorTaskTrampoline,
+			        "ESPTmrExecutor",
+			        stack,
+			        cfg_.priorityExecutor,
+			        static_cast<int8_t>(i),
+			        &executor,
+			        executor.handle,
+			        executorBit(executor)
+			    )) {
+				break;
+			}
+			restarted = false;
+		}
+	}
+	return restarted;
+}
+
+uint32_t ESPTimer::setTimeout(std::function<void()> cb, uint32_t delayMs, int8_t core) {
+	return createTimeout(std::move(cb), delayMs, false, core);
+}
+
+uint32_t ESPTimer::setDebounce(std::function<void()> cb, uint32_t delayMs) {
+	return createTimeout(std::move(cb), delayMs, true, -1);
+}
+
+uint32_t ESPTimer::setThrottle(std::function<void()> cb, uint32_t periodMs) {
+	return createTimeout(std::move(cb), periodMs, true, -1);
+}
+
+// Persistent handles start idle (Completed) with their last fire one delay in the past, so the
+// first throttle() trigger fires immediately.
+uint32_t ESPTimer::createTimeout(
+    std::function<void()> cb,
+    uint32_t delayMs,
+    bool persistent,
+    int8_t core,
+    const EventTarget *event,
+    ESPTimerResumeNode *resume
+) {
+	Shard &shard = shardFor(core);
+	auto &lane = shard.timeouts;
+	if ((!cb && !event && !resume) || !lane.lock()) {
+		return 0;
 	}
 	if (lifecycleState_.load(std::memory_order_acquire) != LifecycleState::Initialized) {
-		unlock();
-		return ESPTimerStatus::Invalid;
+		lane.unlock();
+		return 0;
 	}
 
-	ESPTimerStatus status = ESPTimerStatus::Invalid;
-	switch (type) {
-	case Type::Timeout:
-		if (const auto *item = findItemById(timeouts_, id)) {
-			status = item->status;
+	size_t index = 0;
+	OverloadNotice notice;
+	TimeoutItem *slot = acquireSlotLocked(lane, index, notice);
+	if (!slot) {
+		lane.unlock();
+		reportOverload(notice);
+		return 0;
+	}
+
+	const uint32_t now = millis();
+	if (persistent) {
+		slot->setPersistent(true);
+		slot->setStatus(ESPTimerStatus::Completed);
+		slot->dueAtMs = now - delayMs;
+	} else {
+		slot->setStatus(ESPTimerStatus::Running);
+		slot->dueAtMs = now + delayMs;
+	}
+	slot->delayMs = delayMs;
+	if (event) {
+		lane.events[index] = *event;
+		slot->setPostsEvents();
+	} else if (resume) {
+		// A sleep is an event timeout without a sink whose only waiter is the coroutine.
+		slot->setPostsEvents();
+		resume->next = nullptr;
+		lane.waiters[index].coroutines = resume;
+		slot->setWaiter(true);
+	} else {
+		lane.callbacks[index] = std::move(cb);
+	}
+
+	const uint32_t id = makeId(Type::Timeout, shardIndex(shard), slot->generation(), index);
+	lane.unlock();
+	reportOverload(notice);
+	return id;
+}
+
+uint32_t ESPTimer::setInterval(std::function<void()> cb, uint32_t periodMs, int8_t core) {
+	return createInterval(std::move(cb), periodMs, false, 0, core);
+}
+
+uint32_t ESPTimer::setTimeoutEvent(
+    const ESPTimerEventSink &sink,
+    uint32_t tag,
+    uint32_t delayMs,
+    int8_t core
+) {
+	if (sink.kind == ESPTimerEventSink::Kind::None || !sink.handle) {
+		return 0;
+	}
+	const EventTarget event{sink, tag, 0};
+	return createTimeout(nullptr, delayMs, false, core, &event);
+}
+
+uint32_t ESPTimer::setIntervalEvent(
+    const ESPTimerEventSink &sink,
+    uint32_t tag,
+    uint32_t periodMs,
+    int8_t core
+) {
+	if (sink.kind == ESPTimerEventSink::Kind::None || !sink.handle) {
+		return 0;
+	}
+	const EventTarget event{sink, tag, 0};
+	return createInterval(nullptr, periodMs, false, 0, core, &event);
+}
+
+uint32_t ESPTimer::setCounterEvent(
+    const ESPTimerEventSink &sink,
+    uint32_t tag,
+    uint32_t totalMs,
+    uint32_t tickMs,
+    int8_t core
+) {
+	if (sink.kind == ESPTimerEventSink::Kind::None || !sink.handle) {
+		return 0;
+	}
+	const EventTarget event{sink, tag, 0};
+	return createCounter(nullptr, totalMs, tickMs, CounterMode::Ticks, core, &event);
+}
+
+uint32_t ESPTimer::setPhasedInterval(
+    std::function<void()> cb,
+    uint32_t periodMs,
+    uint32_t phaseMs,
+    int8_t core
+) {
+	return createInterval(std::move(cb), periodMs, true, phaseMs, core);
+}
+
+uint32_t ESPTimer::createInterval(
+    std::function<void()> cb,
+    uint32_t periodMs,
+    bool explicitPhase,
+    uint32_t phaseMs,
+    int8_t core,
+    const EventTarget *event
+) {
+	Shard &shard = shardFor(core);
+	auto &lane = shard.intervals;
+	if ((!cb && !event) || !lane.lock()) {
+		return 0;
+	}
+	if (lifecycleState_.load(std::memory_order_acquire) != LifecycleState::Initialized) {
+		lane.unlock();
+		return 0;
+	}
+
+	const uint32_t now = millis();
+	uint32_t phase = 0;
+	if (explicitPhase) {
+		phase = periodMs > 0 ? phaseMs % periodMs : 0;
+	} else if (tunables_.staggerIntervals.load(std::memory_order_relaxed)) {
+		phase = staggeredPhaseLocked(lane, periodMs, now);
+	}
+
+	size_t index = 0;
+	OverloadNotice notice;
+	IntervalItem *slot = acquireSlotLocked(lane, index, notice);
+	if (!slot) {
+		lane.unlock();
+		reportOverload(notice);
+		return 0;
+	}
+
+	slot->setStatus(ESPTimerStatus::Running);
+	slot->periodMs = periodMs;
+	slot->lastFireMs = now + phase;
+	if (event) {
+		lane.events[index] = *event;
+		slot->setPostsEvents();
+	} else {
+		lane.callbacks[index] = std::move(cb);
+	}
+
+	const uint32_t id = makeId(Type::Interval, shardIndex(shard), slot->generation(), index);
+	lane.unlock();
+	reportOverload(notice);
+	return id;
+}
+
+// The k-th live interval of a period (k counted before this one) lands at the k-th point of the
+// base-2 van der Corput sequence (0, 1/2, 1/4, 3/4, 1/8, ...) after the next fire of the first
+// one, so any number of same-period intervals stays evenly spread without moving existing ones.
+uint32_t ESPTimer::staggeredPhaseLocked(
+    const Lane<IntervalItem, TimedDispatch> &lane,
+    uint32_t periodMs,
+    uint32_t now
+) const {
+	if (periodMs == 0) {
+		return 0;
+	}
+
+	uint32_t peers = 0;
+	uint32_t anchorMs = 0;
+	lane.slots.forEach([&](size_t index) {
+		const IntervalItem &item = lane.items[index];
+		if (item.periodMs != periodMs || item.status() == ESPTimerStatus::Stopped) {
+			return;
 		}
-		break;
-	case Type::Interval:
-		if (const auto *item = findItemById(intervals_, id)) {
-			status = item->status;
+		if (peers == 0) {
+			anchorMs = item.lastFireMs + periodMs;
+		}
+		++peers;
+	});
+	if (peers == 0) {
+		return 0;
+	}
+
+	uint32_t reversed = 0;
+	for (uint32_t bits = peers, i = 0; i < 32; ++i, bits >>= 1) {
+		reversed = (reversed << 1) | (bits & 1u);
+	}
+	const auto offset = static_cast<uint32_t>((static_cast<uint64_t>(reversed) * periodMs) >> 32);
+	return (anchorMs + offset - now) % periodMs;
+}
+
+uint32_t ESPTimer::setCounter(
+    std::function<void(uint32_t)> cb,
+    uint32_t totalMs,
+    uint32_t tickMs,
+    int8_t core
+) {
+	if (!cb) {
+		return 0;
+	}
+	return createCounter(
+	    [cb = std::move(cb)](uint32_t ticksLeft) -> uint32_t {
+		    cb(ticksLeft);
+		    return 0;
+	    },
+	    totalMs,
+	    tickMs,
+	    CounterMode::Ticks,
+	    core
+	);
+}
+
+uint32_t ESPTimer::setSecCounter(std::function<void(int)> cb, uint32_t totalMs) {
+	if (!cb) {
+		return 0;
+	}
+	return createCounter(
+	    [cb = std::move(cb)](uint32_t secLeft) -> uint32_t {
+		    cb(static_cast<int>(secLeft));
+		    return 0;
+	    },
+	    totalMs,
+	    1000,
+	    CounterMode::Ticks,
+	    -1
+	);
+}
+
+uint32_t ESPTimer::setMsCounter(
+    std::function<void(uint32_t)> cb,
+    uint32_t totalMs,
+    uint32_t minIntervalMs
+) {
+	if (!cb) {
+		return 0;
+	}
+	return createCounter(
+	    [cb = std::move(cb)](uint32_t msLeft) -> uint32_t {
+		    cb(msLeft);
+		    return 0;
+	    },
+	    totalMs,
+	    minIntervalMs > 0 ? minIntervalMs : 1,
+	    CounterMode::Milliseconds,
+	    -1
+	);
+}
+
+uint32_t ESPTimer::setMinCounter(std::function<void(int)> cb, uint32_t totalMs) {
+	if (!cb) {
+		return 0;
+	}
+	return createCounter(
+	    [cb = std::move(cb)](uint32_t minLeft) -> uint32_t {
+		    cb(static_cast<int>(minLeft));
+		    return 0;
+	    },
+	    totalMs,
+	    60000,
+	    CounterMode::Ticks,
+	    -1
+	);
+}
+
+uint32_t
+ESPTimer::setAdaptiveMsCounter(std::function<uint32_t(uint32_t)> cb, uint32_t totalMs) {
+	return createCounter(std::move(cb), totalMs, 1, CounterMode::Adaptive, -1);
+}
+
+uint32_t ESPTimer::createCounter(
+    CounterItem::Callback cb,
+    uint32_t totalMs,
+    uint32_t tickMs,
+    CounterMode mode,
+    int8_t core,
+    const EventTarget *event
+) {
+	Shard &shard = shardFor(core);
+	auto &lane = shard.counters;
+	if ((!cb && !event) || tickMs == 0 || !lane.lock()) {
+		return 0;
+	}
+	if (lifecycleState_.load(std::memory_order_acquire) != LifecycleState::Initialized) {
+		lane.unlock();
+		return 0;
+	}
+
+	size_t index = 0;
+	OverloadNotice notice;
+	CounterItem *slot = acquireSlotLocked(lane, index, notice);
+	if (!slot) {
+		lane.unlock();
+		reportOverload(notice);
+		return 0;
+	}
+
+	slot->setStatus(ESPTimerStatus::Running);
+	const uint32_t now = millis();
+	slot->endAtMs = now + totalMs;
+	slot->tickMs = tickMs;
+	slot->mode = mode;
+	slot->nextTickMs = nextCounterTick(*slot, now);
+	if (event) {
+		lane.events[index] = *event;
+		slot->setPostsEvents();
+	} else {
+		lane.callbacks[index] = std::move(cb);
+	}
+
+	const uint32_t id = makeId(Type::Counter, shardIndex(shard), slot->generation(), index);
+	wakeCounterWorkerLocked(shard);
+	lane.unlock();
+	reportOverload(notice);
+	return id;
+}
+
+// Routes a state change to the shard that owns `id`. On the owning core (or unsharded) it is
+// applied under the lane lock; from the other core, timing changes are queued to the owner's
+// inbox, falling back to the lane lock only when the inbox is full. Pause, resume, toggle and
+// clear always take the lane lock so their result and the status are final on return.
+bool ESPTimer::control(Type type, ControlOp op, uint32_t id, uint32_t arg) {
+	Type idType = Type::Timeout;
+	uint8_t owner = 0;
+	uint16_t generation = 0;
+	size_t index = 0;
+	if (!decodeId(id, idType, owner, generation, index) || idType != type) {
+		return false;
+	}
+
+	Shard &shard = shards_[owner];
+	const ControlCommand command{id, arg, op};
+	const bool changesStatus = op == ControlOp::Pause || op == ControlOp::Resume ||
+	                           op == ControlOp::Toggle || op == ControlOp::Clear;
+	if (!changesStatus && owner != currentShard()) {
+		bool accepted = false;
+		if (postControl(shard, type, command, accepted)) {
+			return accepted;
+		}
+	}
+
+	bool result = false;
+	withLaneLocked(shard, type, [&](auto &lane) {
+		result = applyControlLocked(shard, lane, command);
+	});
+	return result;
+}
+
+// Lock-free: counted in `lockFreeUsers_` so deinit() keeps storage and workers alive until it
+// returns. Returns false when the command could not be queued and must take the lock instead.
+bool ESPTimer::postControl(
+    Shard &shard,
+    Type type,
+    const ControlCommand &command,
+    bool &accepted
+) {
+	accepted = false;
+	bool handled = true;
+	lockFreeUsers_.fetch_add(1);
+	if (lifecycleState_.load() == LifecycleState::Initialized) {
+		Type idType = Type::Timeout;
+		uint8_t owner = 0;
+		uint16_t generation = 0;
+		size_t index = 0;
+		decodeId(command.id, idType, owner, generation, index);
+		auto post = [&](auto &lane) {
+			if (lane.exclusive.load()) {
+				handled = false;
+				return;
+			}
+			const ESPTimerStatus status = peekStatus(lane, index, generation);
+			if (status == ESPTimerStatus::Invalid || status == ESPTimerStatus::Stopped) {
+				return;
+			}
+			if (!lane.inbox.push(command)) {
+				handled = false;
+				return;
+			}
+			accepted = true;
+		};
+
+		switch (type) {
+		case Type::Timeout:
+			post(shard.timeouts);
+			break;
+		case Type::Interval:
+			post(shard.intervals);
+			break;
+		case Type::Counter:
+			post(shard.counters);
+			if (accepted && shard.hCounter) {
+				xTaskNotifyGive(shard.hCounter);
+			}
+			break;
+		}
+	}
+	lockFreeUsers_.fetch_sub(1, std::memory_order_release);
+	return handled;
+}
+
+template <typename Item, typename Dispatch>
+bool ESPTimer::applyControlLocked(
+    Shard &shard,
+    Lane<Item, Dispatch> &lane,
+    const ControlCommand &command
+) {
+	size_t index = 0;
+	Item *item = findItemById(lane, command.id, index);
+	if (!item) {
+		return false;
+	}
+
+	const ESPTimerStatus status = item->status();
+	switch (command.op) {
+	case ControlOp::Pause:
+		if (status != ESPTimerStatus::Running) {
+			return false;
+		}
+		item->setStatus(ESPTimerStatus::Paused);
+		return true;
+	case ControlOp::Resume:
+	case ControlOp::Toggle:
+		if (status == ESPTimerStatus::Running && command.op == ControlOp::Toggle) {
+			item->setStatus(ESPTimerStatus::Paused);
+			return false;
+		}
+		if (status != ESPTimerStatus::Paused) {
+			return false;
+		}
+		item->setStatus(ESPTimerStatus::Running);
+		if constexpr (std::is_same_v<Item, IntervalItem>) {
+			item->lastFireMs = millis();
+		} else if constexpr (std::is_same_v<Item, CounterItem>) {
+			item->nextTickMs = nextCounterTick(*item, millis());
+			wakeCounterWorkerLocked(shard);
+		}
+		return true;
+	case ControlOp::Clear:
+		item->setStatus(ESPTimerStatus::Stopped);
+		if (!item->executing()) {
+			releaseSlotLocked(lane, index);
+		}
+		return true;
+	case ControlOp::SetPriority:
+		if (status == ESPTimerStatus::Stopped) {
+			return false;
 		}
+		item->setPriority(static_cast<ESPTimerPriority>(command.arg));
+		return true;
+	default:
 		break;
-	case Type::Sec:
-		if (const auto *item = findItemById(secs_, id)) {
-			status = item->status;
+	}
+
+	if constexpr (std::is_same_v<Item, TimeoutItem>) {
+		const uint32_t now = millis();
+		switch (command.op) {
+		case ControlOp::Restart:
+		case ControlOp::Reschedule:
+			if (status != ESPTimerStatus::Running && status != ESPTimerStatus::Paused) {
+				return false;
+			}
+			if (command.op == ControlOp::Reschedule) {
+				item->delayMs = command.arg;
+			}
+			item->dueAtMs = now + item->delayMs;
+			if (item->executing()) {
+				item->setRearmed(true);
+			}
+			return true;
+		case ControlOp::Debounce:
+			if (!item->persistent() || status == ESPTimerStatus::Stopped) {
+				return false;
+			}
+			item->dueAtMs = now + item->delayMs;
+			if (status == ESPTimerStatus::Paused) {
+				return true;
+			}
+			if (item->executing()) {
+				item->setRearmed(true);
+			}
+			item->setStatus(ESPTimerStatus::Running);
+			return true;
+		case ControlOp::Throttle: {
+			if (!item->persistent() || status == ESPTimerStatus::Stopped) {
+				return false;
+			}
+			// Once idle, `dueAtMs` is the time of the last fire, so the next window opens
+			// `delayMs` after it. A pending call absorbs the trigger.
+			const bool pending = status == ESPTimerStatus::Paused ||
+			                     (status == ESPTimerStatus::Running &&
+			                      (!item->executing() || item->rearmed()));
+			if (pending) {
+				return true;
+			}
+			const uint32_t windowEnd = item->dueAtMs + item->delayMs;
+			item->dueAtMs = deadlineReached(now, windowEnd) ? now : windowEnd;
+			if (item->executing()) {
+				item->setRearmed(true);
+			}
+			item->setStatus(ESPTimerStatus::Running);
+			return true;
 		}
-		break;
-	case Type::Ms:
-		if (const auto *item = findItemById(mss_, id)) {
-			status = item->status;
+		default:
+			return false;
 		}
-		break;
-	case Type::Min:
-		if (const auto *item = findItemById(mins_, id)) {
-			status = item->status;
+	} else if constexpr (std::is_same_v<Item, IntervalItem>) {
+		if (command.op != ControlOp::SetPeriod ||
+		    (status != ESPTimerStatus::Running && status != ESPTimerStatus::Paused)) {
+			return false;
 		}
-		break;
+		item->periodMs = command.arg;
+		return true;
+	} else {
+		return false;
 	}
+}
 
-	unlock();
-	return status;
+// Worker side of the cross-core inbox; runs with the lane locked at the start of each pass.
+template <typename Item, typename Dispatch>
+void ESPTimer::drainInboxLocked(Shard &shard, Lane<Item, Dispatch> &lane) {
+	ControlCommand command;
+	while (lane.inbox.pop(command)) {
+		applyControlLocked(shard, lane, command);
+	}
+}
+
+template <typename Item, typename Dispatch>
+ESPTimerStatus
+ESPTimer::peekStatus(const Lane<Item, Dispatch> &lane, size_t index, uint16_t generation) const {
+	if (index >= lane.items.size()) {
+		return ESPTimerStatus::Invalid;
+	}
+	const uint32_t word = lane.items[index].word.load(std::memory_order_acquire);
+	if ((word >> BaseItem::kGenerationShift) != generation) {
+		return ESPTimerStatus::Invalid;
+	}
+	return static_cast<ESPTimerStatus>(word & BaseItem::kStatusMask);
 }
 
 bool ESPTimer::pauseTimer(uint32_t id) {
-	return pauseItem(Type::Timeout, id);
+	return control(Type::Timeout, ControlOp::Pause, id);
 }
 
 bool ESPTimer::pauseInterval(uint32_t id) {
-	return pauseItem(Type::Interval, id);
+	return control(Type::Interval, ControlOp::Pause, id);
+}
+
+bool ESPTimer::pauseCounter(uint32_t id) {
+	return control(Type::Counter, ControlOp::Pause, id);
 }
 
 bool ESPTimer::pauseSecCounter(uint32_t id) {
-	return pauseItem(Type::Sec, id);
+	return pauseCounter(id);
 }
 
 bool ESPTimer::pauseMsCounter(uint32_t id) {
-	return pauseItem(Type::Ms, id);
+	return pauseCounter(id);
 }
 
 bool ESPTimer::pauseMinCounter(uint32_t id) {
-	return pauseItem(Type::Min, id);
+	return pauseCounter(id);
 }
 
 bool ESPTimer::resumeTimer(uint32_t id) {
-	return resumeItem(Type::Timeout, id);
+	return control(Type::Timeout, ControlOp::Resume, id);
 }
 
 bool ESPTimer::resumeInterval(uint32_t id) {
-	return resumeItem(Type::Interval, id);
+	return control(Type::Interval, ControlOp::Resume, id);
+}
+
+bool ESPTimer::resumeCounter(uint32_t id) {
+	return control(Type::Counter, ControlOp::Resume, id);
 }
 
 bool ESPTimer::resumeSecCounter(uint32_t id) {
-	return resumeItem(Type::Sec, id);
+	return resumeCounter(id);
 }
 
 bool ESPTimer::resumeMsCounter(uint32_t id) {
-	return resumeItem(Type::Ms, id);
+	return resumeCounter(id);
 }
 
 bool ESPTimer::resumeMinCounter(uint32_t id) {
-	return resumeItem(Type::Min, id);
+	return resumeCounter(id);
 }
 
 bool ESPTimer::toggleRunStatusTimer(uint32_t id) {
-	return togglePause(Type::Timeout, id) == ESPTimerStatus::Running;
+	return control(Type::Timeout, ControlOp::Toggle, id);
 }
 
 bool ESPTimer::toggleRunStatusInterval(uint32_t id) {
-	return togglePause(Type::Interval, id) == ESPTimerStatus::Running;
+	return control(Type::Interval, ControlOp::Toggle, id);
+}
+
+bool ESPTimer::toggleRunStatusCounter(uint32_t id) {
+	return control(Type::Counter, ControlOp::Toggle, id);
 }
 
 bool ESPTimer::toggleRunStatusSecCounter(uint32_t id) {
-	return togglePause(Type::Sec, id) == ESPTimerStatus::Running;
+	return toggleRunStatusCounter(id);
 }
 
 bool ESPTimer::toggleRunStatusMsCounter(uint32_t id) {
-	return togglePause(Type::Ms, id) == ESPTimerStatus::Running;
+	return toggleRunStatusCounter(id);
 }
 
 bool ESPTimer::toggleRunStatusMinCounter(uint32_t id) {
-	return togglePause(Type::Min, id) == ESPTimerStatus::Running;
+	return toggleRunStatusCounter(id);
 }
 
 bool ESPTimer::clearTimeout(uint32_t id) {
-	return clearItem(Type::Timeout, id);
+	return control(Type::Timeout, ControlOp::Clear, id);
 }
 
 bool ESPTimer::clearInterval(uint32_t id) {
-	return clearItem(Type::Interval, id);
+	return control(Type::Interval, ControlOp::Clear, id);
+}
+
+bool ESPTimer::clearCounter(uint32_t id) {
+	return control(Type::Counter, ControlOp::Clear, id);
 }
 
 bool ESPTimer::clearSecCounter(uint32_t id) {
-	return clearItem(Type::Sec, id);
+	return clearCounter(id);
 }
 
 bool ESPTimer::clearMsCounter(uint32_t id) {
-	return clearItem(Type::Ms, id);
+	return clearCounter(id);
 }
 
 bool ESPTimer::clearMinCounter(uint32_t id) {
-	return clearItem(Type::Min, id);
+	return clearCounter(id);
 }
 
-ESPTimerStatus ESPTimer::getStatusLocked(uint32_t id) const {
-	if (const auto *item = findItemById(timeouts_, id)) {
-		return item->status;
-	}
-	if (const auto *item = findItemById(intervals_, id)) {
-		return item->status;
-	}
-	if (const auto *item = findItemById(secs_, id)) {
-		return item->status;
-	}
-	if (const auto *item = findItemById(mss_, id)) {
-		return item->status;
-	}
-	if (const auto *item = findItemById(mins_, id)) {
-		return item->status;
+bool ESPTimer::restartTimeout(uint32_t id) {
+	return control(Type::Timeout, ControlOp::Restart, id);
+}
+
+bool ESPTimer::rescheduleTimeout(uint32_t id, uint32_t newDelayMs) {
+	return control(Type::Timeout, ControlOp::Reschedule, id, newDelayMs);
+}
+
+bool ESPTimer::setIntervalPeriod(uint32_t id, uint32_t newPeriodMs) {
+	return control(Type::Interval, ControlOp::SetPeriod, id, newPeriodMs);
+}
+
+bool ESPTimer::setPriority(uint32_t id, ESPTimerPriority priority) {
+	Type type = Type::Timeout;
+	uint8_t shard = 0;
+	uint16_t generation = 0;
+	size_t index = 0;
+	if (!decodeId(id, type, shard, generation, index) || priority > ESPTimerPriority::High) {
+		return false;
 	}
-	return ESPTimerStatus::Invalid;
+	return control(type, ControlOp::SetPriority, id, static_cast<uint32_t>(priority));
+}
+
+bool ESPTimer::debounce(uint32_t id) {
+	return control(Type::Timeout, ControlOp::Debounce, id);
+}
+
+bool ESPTimer::throttle(uint32_t id) {
+	return control(Type::Timeout, ControlOp::Throttle, id);
 }
 
 ESPTimerStatus ESPTimer::getStatus(uint32_t id) {
-	if (!lock()) {
-		return ESPTimerStatus::Invalid;
-	}
-	if (lifecycleState_.load(std::memory_order_acquire) != LifecycleState::Initialized) {
-		unlock();
+	Type type = Type::Timeout;
+	uint8_t shard = 0;
+	uint16_t generation = 0;
+	size_t index = 0;
+	if (!decodeId(id, type, shard, generation, index)) {
 		return ESPTimerStatus::Invalid;
 	}
 
-	const ESPTimerStatus status = getStatusLocked(id);
-	unlock();
+	// Readers announce themselves before checking the lifecycle so deinit() can wait for them
+	// to leave before it frees the slot storage they are peeking at.
+	lockFreeUsers_.fetch_add(1);
+	ESPTimerStatus status = ESPTimerStatus::Invalid;
+	auto peek = [&](const auto &lane) {
+		if (!lane.exclusive.load()) {
+			status = peekStatus(lane, index, generation);
+		} else if (lane.lock()) {
+			status = peekStatus(lane, index, generation);
+			lane.unlock();
+		}
+	};
+	if (lifecycleState_.load() == LifecycleState::Initialized) {
+		switch (type) {
+		case Type::Timeout:
+			peek(shards_[shard].timeouts);
+			break;
+		case Type::Interval:
+			peek(shards_[shard].intervals);
+			break;
+		case Type::Counter:
+			peek(shards_[shard].counters);
+			break;
+		}
+	}
+	lockFreeUsers_.fetch_sub(1, std::memory_order_release);
 	return status;
 }
 
-void ESPTimer::timeoutTaskTrampoline(void *arg) {
-	static_cast<ESPTimer *>(arg)->timeoutTask();
+ESPTimerAwaiter ESPTimer::sleepFor(uint32_t delayMs, int8_t core) {
+	return ESPTimerAwaiter(*this, 0, delayMs, core);
 }
 
-void ESPTimer::intervalTaskTrampoline(void *arg) {
-	static_cast<ESPTimer *>(arg)->intervalTask();
+ESPTimerAwaiter ESPTimer::nextTick(uint32_t id) {
+	return ESPTimerAwaiter(*this, id, 0, -1);
 }
 
-void ESPTimer::secTaskTrampoline(void *arg) {
-	static_cast<ESPTimer *>(arg)->secTask();
-}
+// Called from await_suspend(). Returning false resumes the coroutine at once with false.
+bool ESPTimer::suspend(ESPTimerAwaiter &awaiter) {
+	if (awaiter.id_ == 0) {
+		const uint32_t id =
+		    createTimeout(nullptr, awaiter.delayMs_, false, awaiter.core_, nullptr, &awaiter.node_);
+		return id != 0;
+	}
 
-void ESPTimer::msTaskTrampoline(void *arg) {
-	static_cast<ESPTimer *>(arg)->msTask();
+	Type type = Type::Timeout;
+	uint8_t shard = 0;
+	uint16_t generation = 0;
+	size_t index = 0;
+	if (!decodeId(awaiter.id_, type, shard, generation, index)) {
+		return false;
+	}
+	bool suspended = false;
+	withLaneLocked(shards_[shard], type, [&](auto &lane) {
+		suspended = addCoroutineLocked(lane, awaiter.id_, awaiter.node_);
+	});
+	return suspended;
 }
 
-void ESPTimer::minTaskTrampoline(void *arg) {
-	static_cast<ESPTimer *>(arg)->minTask();
-}
+// Registers the calling task on the slot and sleeps on its notification value. Workers notify
+// and unregister under the lane lock, so after a timeout either the registration is withdrawn
+// here or the notification has already been sent and is consumed instead.
+bool ESPTimer::waitFor(uint32_t id, TickType_t timeoutTicks) {
+	Type type = Type::Timeout;
+	uint8_t shard = 0;
+	uint16_t generation = 0;
+	size_t index = 0;
+	if (!decodeId(id, type, shard, generation, index)) {
+		return false;
+	}
 
-void ESPTimer::timeoutTask() {
-	while (running_.load(std::memory_order_acquire)) {
-		const uint32_t now = millis();
-		if (lock()) {
-			timeoutDispatch_.clear();
-			clearStoppedLocked(timeouts_, Type::Timeout);
+	constexpr uint32_t kWaitBits = kWaitFiredBit | kWaitEndedBit;
+	TaskHandle_t self = xTaskGetCurrentTaskHandle();
+	ulTaskNotifyValueClear(self, kWaitBits);
+	bool registered = false;
+	withLaneLocked(shards_[shard], type, [&](auto &lane) {
+		registered = addWaiterLocked(lane, id, self);
+	});
+	if (!registered) {
+		return false;
+	}
 
-			for (size_t index = 0; index < timeouts_.size(); ++index) {
-				auto &item = timeouts_[index];
-				if (!item.active || item.executing || item.status != ESPTimerStatus::Running) {
-					continue;
-				}
-				if (now >= item.dueAtMs) {
-					item.executing = true;
-					if (!timerTryPushBack(timeoutDispatch_, TimedDispatch{index})) {
-						item.executing = false;
-					}
-				}
+	// Notifications from other sources wake the task too; keep sleeping until ours arrives.
+	const TickType_t start = xTaskGetTickCount();
+	uint32_t value = 0;
+	for (;;) {
+		TickType_t remaining = portMAX_DELAY;
+		if (timeoutTicks != portMAX_DELAY) {
+			const TickType_t elapsed = xTaskGetTickCount() - start;
+			remaining = elapsed < timeoutTicks ? timeoutTicks - elapsed : 0;
+		}
+		xTaskNotifyWait(0, kWaitBits, &value, remaining);
+		if ((value & kWaitBits) != 0 || remaining == 0) {
+			break;
+		}
+	}
+
+	if ((value & kWaitBits) == 0) {
+		bool withdrawn = false;
+		auto withdraw = [&](auto &lane) {
+			if (lane.lock()) {
+				withdrawn = removeWaiterLocked(lane, id, self);
+				lane.unlock();
 			}
+		};
+		switch (type) {
+		case Type::Timeout:
+			withdraw(shards_[shard].timeouts);
+			break;
+		case Type::Interval:
+			withdraw(shards_[shard].intervals);
+			break;
+		case Type::Counter:
+			withdraw(shards_[shard].counters);
+			break;
+		}
+		if (!withdrawn) {
+			xTaskNotifyWait(0, kWaitBits, &value, 0);
+		}
+	}
+	return (value & kWaitFiredBit) != 0;
+}
 
-			unlock();
+bool ESPTimer::isRunning(uint32_t id) {
+	return getStatus(id) == ESPTimerStatus::Running;
+}
+
+void ESPTimer::waitForLockFreeUsers() const {
+	while (lockFreeUsers_.load(std::memory_order_acquire) != 0) {
+		vTaskDelay(1);
+	}
+}
+
+ESPTimerMemoryFootprint ESPTimer::memoryFootprint() const {
+	ESPTimerMemoryFootprint footprint;
+	if (!lock()) {
+		return footprint;
+	}
+	if (lifecycleState_.load(std::memory_order_acquire) == LifecycleState::Initialized) {
+		for (uint8_t i = 0; i < shardCount_.load(std::memory_order_relaxed); ++i) {
+			addLaneFootprint(footprint.timeouts, shards_[i].timeouts);
+			addLaneFootprint(footprint.intervals, shards_[i].intervals);
+			addLaneFootprint(footprint.counters, shards_[i].counters);
 		}
+		for (uint8_t i = 0; i < executorCount_.load(std::memory_order_relaxed); ++i) {
+			footprint.executorBytes += executors_[i].jobs.memoryBytes();
+		}
+	}
+	unlock();
+	return footprint;
+}
 
-		for (const auto &dispatch : timeoutDispatch_) {
-			std::function<void()> *callback = nullptr;
-			if (lock()) {
-				if (dispatch.index < timeouts_.size()) {
-					auto &item = timeouts_[dispatch.index];
-					if (item.active && item.executing) {
-						callback = &item.cb;
-					}
-				}
-				unlock();
-			}
+ESPTimerLatenessStats ESPTimer::latenessStats() const {
+	uint32_t histograms[3][kLatenessBuckets] = {};
+	uint32_t maxMs[3] = {};
+	for (const Shard &shard : shards_) {
+		addLaneLateness(shard.timeouts, histograms[0], maxMs[0]);
+		addLaneLateness(shard.intervals, histograms[1], maxMs[1]);
+		addLaneLateness(shard.counters, histograms[2], maxMs[2]);
+	}
 
-			if (callback) {
-				invokeTimerCallback(*callback);
-			}
+	ESPTimerLatenessStats stats;
+	stats.timeouts = summarizeLateness(histograms[0], maxMs[0]);
+	stats.intervals = summarizeLateness(histograms[1], maxMs[1]);
+	stats.counters = summarizeLateness(histograms[2], maxMs[2]);
+	return stats;
+}
 
-			if (lock()) {
-				if (dispatch.index < timeouts_.size()) {
-					auto &item = timeouts_[dispatch.index];
-					if (item.active && item.executing) {
-						item.executing = false;
-						if (item.status == ESPTimerStatus::Running) {
-							item.status = ESPTimerStatus::Completed;
-						}
-						if (item.status == ESPTimerStatus::Stopped ||
-						    item.status == ESPTimerStatus::Completed) {
-							resetItem(item, Type::Timeout);
-						}
-					}
-				}
-				unlock();
-			}
+ESPTimerLoadStats ESPTimer::loadStats() const {
+	ESPTimerLoadStats stats;
+	auto add = [](ESPTimerLaneLoad &total, const LaneLoad &load) {
+		total.peakSlots = std::max(total.peakSlots, load.peakSlots.load(std::memory_order_relaxed));
+		total.occupancyAlarms += load.occupancyAlarms.load(std::memory_order_relaxed);
+		total.latenessAlarms += load.latenessAlarms.load(std::memory_order_relaxed);
+		total.rejected += load.rejected.load(std::memory_order_relaxed);
+		total.evicted += load.evicted.load(std::memory_order_relaxed);
+		total.overflowed += load.overflowed.load(std::memory_order_relaxed);
+	};
+	for (const Shard &shard : shards_) {
+		add(stats.timeouts, shard.timeouts.load);
+		add(stats.intervals, shard.intervals.load);
+		add(stats.counters, shard.counters.load);
+	}
+	return stats;
+}
+
+void ESPTimer::resetLatenessStats() {
+	forEachLane([](auto &lane) {
+		for (auto &bucket : lane.lateness) {
+			bucket.store(0, std::memory_order_relaxed);
 		}
+		lane.maxLatenessMs.store(0, std::memory_order_relaxed);
+	});
+}
 
-		vTaskDelay(pdMS_TO_TICKS(1));
+bool ESPTimer::startCyclic(
+    const ESPTimerCyclicTask *tasks,
+    size_t count,
+    const ESPTimerCyclicConfig &cfg
+) {
+	if (!lock()) {
+		return false;
+	}
+	if (lifecycleState_.load(std::memory_order_acquire) != LifecycleState::Initialized ||
+	    cyclic_.active || !buildCyclicLocked(tasks, count)) {
+		unlock();
+		return false;
 	}
 
-	if (lock()) {
-		markTaskExited(Type::Timeout);
+	cyclic_.cfg = cfg;
+	if (cyclic_.cfg.stackSize == 0) {
+		cyclic_.cfg.stackSize = 4096 * sizeof(StackType_t);
+	}
+	cyclic_.frames.store(0, std::memory_order_relaxed);
+	cyclic_.overruns.store(0, std::memory_order_relaxed);
+	cyclic_.maxFrameUs.store(0, std::memory_order_relaxed);
+	cyclic_.running.store(true, std::memory_order_release);
+	if (!tryCreateWorkerLocked(
+	        &ESPTimer::cyclicTaskTrampoline,
+	        "ESPTmrCyclic",
+	        cyclic_.cfg.stackSize,
+	        cyclic_.cfg.priority,
+	        cyclic_.cfg.core,
+	        this,
+	        cyclic_.handle,
+	        kCyclicExitBit
+	    )) {
+		cyclic_.running.store(false, std::memory_order_release);
+		releaseCyclicLocked();
 		unlock();
-	} else {
-		hTimeout_ = nullptr;
+		return false;
 	}
-	vTaskDelete(nullptr);
+
+	cyclic_.active = true;
+	unlock();
+	return true;
 }
 
-void ESPTimer::intervalTask() {
-	while (running_.load(std::memory_order_acquire)) {
-		const uint32_t now = millis();
-		if (lock()) {
-			intervalDispatch_.clear();
-			clearStoppedLocked(intervals_, Type::Interval);
+void ESPTimer::stopCyclic() {
+	stopCyclic(pdMS_TO_TICKS(kJoinTimeoutMs));
+}
 
-			for (size_t index = 0; index < intervals_.size(); ++index) {
-				auto &item = intervals_[index];
-				if (!item.active || item.executing || item.status != ESPTimerStatus::Running) {
-					continue;
-				}
-				if (now - item.lastFireMs >= item.periodMs) {
-					item.lastFireMs = now;
-					item.executing = true;
-					if (!timerTryPushBack(intervalDispatch_, TimedDispatch{index})) {
-						item.executing = false;
-					}
-				}
-			}
+// Returns false when the cyclic task is still in a frame after `timeout`. The schedule then stays
+// allocated and the next call resumes the join.
+bool ESPTimer::stopCyclic(TickType_t timeout) {
+	if (!lock()) {
+		return false;
+	}
+	if (!cyclic_.active) {
+		unlock();
+		return true;
+	}
+	cyclic_.running.store(false, std::memory_order_release);
+	unlock();
 
-			unlock();
+	const bool joined = joinWorkers(kCyclicExitBit, timeout);
+	if (joined && lock()) {
+		if (cyclic_.handle) {
+			vTaskDelete(cyclic_.handle);
+			cyclic_.handle = nullptr;
 		}
+		releaseCyclicLocked();
+		unlock();
+	}
+	return joined;
+}
 
-		for (const auto &dispatch : intervalDispatch_) {
-			std::function<void()> *callback = nullptr;
-			if (lock()) {
-				if (dispatch.index < intervals_.size()) {
-					auto &item = intervals_[dispatch.index];
-					if (item.active && item.executing) {
-						callback = &item.cb;
-					}
-				}
-				unlock();
-			}
+ESPTimerCyclicStats ESPTimer::cyclicStats() const {
+	ESPTimerCyclicStats stats;
+	if (!lock()) {
+		return stats;
+	}
+	if (cyclic_.active) {
+		stats.minorFrameMs = cyclic_.minorMs;
+		stats.majorFrameMs = cyclic_.majorMs;
+		stats.frames = cyclic_.frames.load(std::memory_order_relaxed);
+		stats.overruns = cyclic_.overruns.load(std::memory_order_relaxed);
+		stats.maxFrameUs = cyclic_.maxFrameUs.load(std::memory_order_relaxed);
+	}
+	unlock();
+	return stats;
+}
 
-			if (callback) {
-				invokeTimerCallback(*callback);
-			}
+// The minor frame divides every period and offset, so each release time of each task falls
+// on a frame boundary; the major frame is where the whole pattern repeats. Frames are released
+// on tick boundaries, so a minor frame that is not a whole number of ticks is rejected rather
+// than run at a rounded rate.
+bool ESPTimer::buildCyclicLocked(const ESPTimerCyclicTask *tasks, size_t count) {
+	if (!tasks || count == 0 || count > UINT16_MAX) {
+		return false;
+	}
 
-			if (lock()) {
-				if (dispatch.index < intervals_.size()) {
-					auto &item = intervals_[dispatch.index];
-					if (item.active && item.executing) {
-						item.executing = false;
-						if (item.status == ESPTimerStatus::Stopped ||
-						    item.status == ESPTimerStatus::Completed) {
-							resetItem(item, Type::Interval);
-						}
-					}
-				}
-				unlock();
-			}
+	uint64_t minorMs = 0;
+	uint64_t majorMs = 1;
+	for (size_t i = 0; i < count; ++i) {
+		const ESPTimerCyclicTask &task = tasks[i];
+		if (!task.callback || task.periodMs == 0 || task.offsetMs >= task.periodMs) {
+			return false;
+		}
+		minorMs = greatestCommonDivisor(minorMs, task.periodMs);
+		minorMs = greatestCommonDivisor(minorMs, task.offsetMs);
+		majorMs = majorMs / greatestCommonDivisor(majorMs, task.periodMs) * task.periodMs;
+		if (majorMs > UINT32_MAX) {
+			return false;
 		}
+	}
 
-		vTaskDelay(pdMS_TO_TICKS(1));
+	if (minorMs * configTICK_RATE_HZ % 1000 != 0) {
+		return false;
 	}
 
-	if (lock()) {
-		markTaskExited(Type::Interval);
-		unlock();
-	} else {
-		hInterval_ = nullptr;
+	const uint64_t frameCount = majorMs / minorMs;
+	uint64_t entries = 0;
+	for (size_t i = 0; i < count; ++i) {
+		entries += majorMs / tasks[i].periodMs;
+	}
+	if (frameCount > kMaxCyclicFrames || entries > UINT16_MAX) {
+		return false;
+	}
+
+	using Callback = IntervalItem::Callback;
+	TimerVector<Callback> callbacks{TimerAllocator<Callback>(callbackRegion_)};
+	TimerVector<uint16_t> frameBegin{TimerAllocator<uint16_t>(slotRegion_)};
+	TimerVector<uint16_t> frameTasks{TimerAllocator<uint16_t>(slotRegion_)};
+	if (!timerTryReserve(callbacks, count) || !timerTryReserve(frameBegin, frameCount + 1) ||
+	    !timerTryReserve(frameTasks, entries)) {
+		return false;
 	}
-	vTaskDelete(nullptr);
+	for (size_t i = 0; i < count; ++i) {
+		timerTryPushBack(callbacks, tasks[i].callback);
+	}
+	for (uint64_t frame = 0; frame < frameCount; ++frame) {
+		timerTryPushBack(frameBegin, static_cast<uint16_t>(frameTasks.size()));
+		const uint64_t atMs = frame * minorMs;
+		for (size_t i = 0; i < count; ++i) {
+			if (atMs % tasks[i].periodMs == tasks[i].offsetMs) {
+				timerTryPushBack(frameTasks, static_cast<uint16_t>(i));
+			}
+		}
+	}
+	timerTryPushBack(frameBegin, static_cast<uint16_t>(frameTasks.size()));
+
+	cyclic_.callbacks.swap(callbacks);
+	cyclic_.frameBegin.swap(frameBegin);
+	cyclic_.frameTasks.swap(frameTasks);
+	cyclic_.minorMs = static_cast<uint32_t>(minorMs);
+	cyclic_.majorMs = static_cast<uint32_t>(majorMs);
+	return true;
 }
 
-void ESPTimer::secTask() {
-	while (running_.load(std::memory_order_acquire)) {
-		const uint32_t now = millis();
-		if (lock()) {
-			secDispatch_.clear();
-			clearStoppedLocked(secs_, Type::Sec);
+void ESPTimer::releaseCyclicLocked() {
+	TimerVector<IntervalItem::Callback>().swap(cyclic_.callbacks);
+	TimerVector<uint16_t>().swap(cyclic_.frameBegin);
+	TimerVector<uint16_t>().swap(cyclic_.frameTasks);
+	cyclic_.cfg = ESPTimerCyclicConfig{};
+	cyclic_.minorMs = 0;
+	cyclic_.majorMs = 0;
+	cyclic_.active = false;
+}
 
-			for (size_t index = 0; index < secs_.size(); ++index) {
-				auto &item = secs_[index];
-				if (!item.active || item.executing || item.status != ESPTimerStatus::Running) {
-					continue;
-				}
-				if (now - item.lastTickMs >= 1000) {
-					item.lastTickMs = now;
-					int secLeft = 0;
-					if (item.endAtMs > now) {
-						const uint32_t remaining = item.endAtMs - now;
-						secLeft = static_cast<int>((static_cast<uint64_t>(remaining) + 999) / 1000);
-					}
-					item.executing = true;
-					if (!timerTryPushBack(secDispatch_, SecDispatch{index, secLeft})) {
-						item.executing = false;
-					} else if (now >= item.endAtMs) {
-						item.status = ESPTimerStatus::Completed;
-					}
-				}
-			}
+void ESPTimer::cyclicTaskTrampoline(void *arg) {
+	static_cast<ESPTimer *>(arg)->cyclicTask();
+}
 
-			unlock();
-		}
+void ESPTimer::timeoutTaskTrampoline(void *arg) {
+	auto &shard = *static_cast<Shard *>(arg);
+	shard.owner->timeoutTask(shard);
+}
 
-		for (const auto &dispatch : secDispatch_) {
-			std::function<void(int)> *callback = nullptr;
-			if (lock()) {
-				if (dispatch.index < secs_.size()) {
-					auto &item = secs_[dispatch.index];
-					if (item.active && item.executing) {
-						callback = &item.cb;
-					}
-				}
-				unlock();
-			}
+void ESPTimer::intervalTaskTrampoline(void *arg) {
+	auto &shard = *static_cast<Shard *>(arg);
+	shard.owner->intervalTask(shard);
+}
 
-			if (callback) {
-				invokeTimerCallback(*callback, dispatch.arg);
-			}
+void ESPTimer::counterTaskTrampoline(void *arg) {
+	auto &shard = *static_cast<Shard *>(arg);
+	shard.owner->counterTask(shard);
+}
 
-			if (lock()) {
-				if (dispatch.index < secs_.size()) {
-					auto &item = secs_[dispatch.index];
-					if (item.active && item.executing) {
-						item.executing = false;
-						if (item.status == ESPTimerStatus::Stopped ||
-						    item.status == ESPTimerStatus::Completed) {
-							resetItem(item, Type::Sec);
-						}
-					}
+void ESPTimer::executorTaskTrampoline(void *arg) {
+	auto &executor = *static_cast<Executor *>(arg);
+	executor.owner->executorTask(executor);
+}
+
+void ESPTimer::timeoutTask(Shard &shard) {
+	auto &lane = shard.timeouts;
+	const uint8_t shardId = shardIndex(shard);
+	while (workerActive(shard, Type::Timeout)) {
+		const uint32_t now = millis();
+		ESPTimerResumeNode *ready = nullptr;
+		TimeoutItem *retired = nullptr;
+		if (lane.lock()) {
+			drainInboxLocked(shard, lane);
+			resetStagingLocked(lane);
+			lane.slots.forEach([&](size_t index) {
+				auto &item = lane.items[index];
+				if (item.executing() || item.status() != ESPTimerStatus::Running) {
+					return;
 				}
-				unlock();
-			}
+				if (!deadlineReached(now, item.dueAtMs)) {
+					return;
+				}
+				if (item.postsEvents()) {
+					postEventLocked(lane, shardId, index, 0, true);
+					return;
+				}
+				const auto slot = static_cast<uint16_t>(index);
+				item.setExecuting(true);
+				const TimedDispatch staged{slot, item.priority(), false, item.dueAtMs};
+				if (!timerTryPushBack(lane.dispatch, staged)) {
+					item.setExecuting(false);
+				}
+			});
+
+			retired = reclaimChunkLocked(lane, now);
+			ready = takeResumableLocked(lane);
+			lane.unlock();
 		}
 
-		vTaskDelay(pdMS_TO_TICKS(10));
-	}
+		releaseChunk(lane, retired);
+		resumeCoroutines(ready);
+		if (dispatchBatch(lane, true)) {
+			taskYIELD(); // let blocked control calls take the lane lock before the rescan
+			continue;
+		}
 
-	if (lock()) {
-		markTaskExited(Type::Sec);
-		unlock();
-	} else {
-		hSec_ = nullptr;
+		vTaskDelay(pdMS_TO_TICKS(1));
 	}
-	vTaskDelete(nullptr);
+
+	parkWorker(workerBit(shard, Type::Timeout));
 }
 
-void ESPTimer::msTask() {
-	while (running_.load(std::memory_order_acquire)) {
+void ESPTimer::intervalTask(Shard &shard) {
+	auto &lane = shard.intervals;
+	const uint8_t shardId = shardIndex(shard);
+	while (workerActive(shard, Type::Interval)) {
 		const uint32_t now = millis();
-		if (lock()) {
-			msDispatch_.clear();
-			clearStoppedLocked(mss_, Type::Ms);
-
-			for (size_t index = 0; index < mss_.size(); ++index) {
-				auto &item = mss_[index];
-				if (!item.active || item.executing || item.status != ESPTimerStatus::Running) {
-					continue;
+		ESPTimerResumeNode *ready = nullptr;
+		IntervalItem *retired = nullptr;
+		if (lane.lock()) {
+			drainInboxLocked(shard, lane);
+			resetStagingLocked(lane);
+			lane.slots.forEach([&](size_t index) {
+				auto &item = lane.items[index];
+				if (item.executing() || item.status() != ESPTimerStatus::Running) {
+					return;
 				}
-				if (now - item.lastTickMs >= 1) {
-					item.lastTickMs = now;
-					uint32_t msLeft = 0;
-					if (item.endAtMs > now) {
-						msLeft = item.endAtMs - now;
+				const uint32_t dueAtMs = item.lastFireMs + item.periodMs;
+				if (deadlineReached(now, dueAtMs)) {
+					// Advance from the deadline, not from `now`, so staggered and phased
+					// schedules keep their offsets however late the scan runs. Periods missed
+					// entirely are skipped rather than fired back to back.
+					const uint32_t periodMs = item.periodMs;
+					const uint32_t missed = periodMs > 0 ? (now - dueAtMs) / periodMs : 0;
+					item.lastFireMs = periodMs > 0 ? dueAtMs + missed * periodMs : now;
+					if (item.postsEvents()) {
+						postEventLocked(lane, shardId, index, ++lane.events[index].fires, false);
+						return;
 					}
-					item.executing = true;
-					if (!timerTryPushBack(msDispatch_, MsDispatch{index, msLeft})) {
-						item.executing = false;
-					} else if (now >= item.endAtMs) {
-						item.status = ESPTimerStatus::Completed;
+					const auto slot = static_cast<uint16_t>(index);
+					item.setExecuting(true);
+					const TimedDispatch staged{slot, item.priority(), false, dueAtMs};
+					if (!timerTryPushBack(lane.dispatch, staged)) {
+						item.setExecuting(false);
 					}
 				}
-			}
+			});
 
-			unlock();
+			retired = reclaimChunkLocked(lane, now);
+			ready = takeResumableLocked(lane);
+			lane.unlock();
 		}
 
-		for (const auto &dispatch : msDispatch_) {
-			std::function<void(uint32_t)> *callback = nullptr;
-			if (lock()) {
-				if (dispatch.index < mss_.size()) {
-					auto &item = mss_[dispatch.index];
-					if (item.active && item.executing) {
-						callback = &item.cb;
-					}
-				}
-				unlock();
-			}
-
-			if (callback) {
-				invokeTimerCallback(*callback, dispatch.arg);
-			}
-
-			if (lock()) {
-				if (dispatch.index < mss_.size()) {
-					auto &item = mss_[dispatch.index];
-					if (item.active && item.executing) {
-						item.executing = false;
-						if (item.status == ESPTimerStatus::Stopped ||
-						    item.status == ESPTimerStatus::Completed) {
-							resetItem(item, Type::Ms);
-						}
-					}
-				}
-				unlock();
-			}
+		releaseChunk(lane, retired);
+		resumeCoroutines(ready);
+		if (dispatchBatch(lane, false)) {
+			taskYIELD(); // let blocked control calls take the lane lock before the rescan
+			continue;
 		}
 
 		vTaskDelay(pdMS_TO_TICKS(1));
 	}
 
-	if (lock()) {
-		markTaskExited(Type::Ms);
-		unlock();
-	} else {
-		hMs_ = nullptr;
-	}
-	vTaskDelete(nullptr);
+	parkWorker(workerBit(shard, Type::Interval));
 }
 
-void ESPTimer::minTask() {
-	while (running_.load(std::memory_order_acquire)) {
+// One worker serves every counter. Each pass fires the counters whose precomputed tick is
+// due, then sleeps until the earliest remaining tick; set*, resume and deinit notify it so new
+// deadlines are picked up at once.
+void ESPTimer::counterTask(Shard &shard) {
+	auto &lane = shard.counters;
+	const uint8_t shardId = shardIndex(shard);
+	while (workerActive(shard, Type::Counter)) {
 		const uint32_t now = millis();
-		if (lock()) {
-			minDispatch_.clear();
-			clearStoppedLocked(mins_, Type::Min);
-
-			for (size_t index = 0; index < mins_.size(); ++index) {
-				auto &item = mins_[index];
-				if (!item.active || item.executing || item.status != ESPTimerStatus::Running) {
-					continue;
+		uint32_t waitMs = kCounterIdleWaitMs;
+		bool adaptiveFired = false;
+		ESPTimerResumeNode *ready = nullptr;
+		CounterItem *retired = nullptr;
+		auto considerWait = [&](const CounterItem &item) {
+			const uint32_t untilTick = item.nextTickMs - now;
+			if (untilTick < waitMs) {
+				waitMs = untilTick;
+			}
+		};
+
+		if (lane.lock()) {
+			drainInboxLocked(shard, lane);
+			resetStagingLocked(lane);
+			lane.slots.forEach([&](size_t index) {
+				auto &item = lane.items[index];
+				if (item.executing() || item.status() != ESPTimerStatus::Running) {
+					return;
 				}
-				if (now - item.lastTickMs >= 60000) {
-					item.lastTickMs = now;
-					int minLeft = 0;
-					if (item.endAtMs > now) {
-						const uint32_t remaining = item.endAtMs - now;
-						minLeft = static_cast<int>(
-						    (static_cast<uint64_t>(remaining) + 60000 - 1) / 60000
+				if (!deadlineReached(now, item.nextTickMs)) {
+					considerWait(item);
+					return;
+				}
+
+				uint32_t left = 0;
+				if (!deadlineReached(now, item.endAtMs)) {
+					left = item.endAtMs - now;
+					if (item.mode == CounterMode::Ticks) {
+						left = static_cast<uint32_t>(
+						    (static_cast<uint64_t>(left) + item.tickMs - 1) / item.tickMs
 						);
 					}
-					item.executing = true;
-					if (!timerTryPushBack(minDispatch_, MinDispatch{index, minLeft})) {
-						item.executing = false;
-					} else if (now >= item.endAtMs) {
-						item.status = ESPTimerStatus::Completed;
+				}
+				if (item.postsEvents()) {
+					const bool last = deadlineReached(now, item.endAtMs);
+					postEventLocked(lane, shardId, index, left, last);
+					if (!last) {
+						item.nextTickMs = nextCounterTick(item, now);
+						considerWait(item);
 					}
+					return;
 				}
-			}
+				const auto slot = static_cast<uint16_t>(index);
+				item.setExecuting(true);
+				const CounterDispatch staged{
+				    slot, item.priority(), false, item.nextTickMs, left, 0
+				};
+				if (!timerTryPushBack(lane.dispatch, staged)) {
+					item.setExecuting(false);
+					return;
+				}
+				if (deadlineReached(now, item.endAtMs)) {
+					item.setStatus(ESPTimerStatus::Completed);
+				} else if (item.mode == CounterMode::Adaptive) {
+					adaptiveFired = true; // next interval is only known after the callback
+				} else {
+					item.nextTickMs = nextCounterTick(item, now);
+					considerWait(item);
+				}
+			});
 
-			unlock();
+			retired = reclaimChunkLocked(lane, now);
+			ready = takeResumableLocked(lane);
+			lane.unlock();
 		}
 
-		for (const auto &dispatch : minDispatch_) {
-			std::function<void(int)> *callback = nullptr;
-			if (lock()) {
-				if (dispatch.index < mins_.size()) {
-					auto &item = mins_[dispatch.index];
-					if (item.active && item.executing) {
-						callback = &item.cb;
-					}
-				}
-				unlock();
-			}
+		releaseChunk(lane, retired);
+		resumeCoroutines(ready);
+		if (dispatchBatch(lane, false)) {
+			taskYIELD(); // let blocked control calls take the lane lock before the rescan
+			continue;
+		}
+		if (adaptiveFired) {
+			continue; // rescan right away to pick up the intervals the callbacks returned
+		}
 
-			if (callback) {
-				invokeTimerCallback(*callback, dispatch.arg);
-			}
+		const TickType_t waitTicks = pdMS_TO_TICKS(waitMs);
+		ulTaskNotifyTake(pdTRUE, waitTicks > 0 ? waitTicks : 1);
+	}
 
-			if (lock()) {
-				if (dispatch.index < mins_.size()) {
-					auto &item = mins_[dispatch.index];
-					if (item.active && item.executing) {
-						item.executing = false;
-						if (item.status == ESPTimerStatus::Stopped ||
-						    item.status == ESPTimerStatus::Completed) {
-							resetItem(item, Type::Min);
-						}
-					}
-				}
-				unlock();
-			}
+	parkWorker(workerBit(shard, Type::Counter));
+}
+
+// Newest job from this core's deque first, otherwise the oldest one from the other core.
+bool ESPTimer::takeJob(Executor &local, Executor &remote, CallbackJob &job) {
+	bool taken = false;
+	if (local.lock()) {
+		taken = local.jobs.popBack(job);
+		local.unlock();
+	}
+	if (!taken && remote.lock()) {
+		taken = remote.jobs.popFront(job);
+		remote.unlock();
+	}
+	return taken;
+}
+
+// joinWorkers() only clears an executor's handle under its mutex, so the task is alive for the
+// notification.
+void ESPTimer::wakeExecutor(Executor &executor) {
+	if (executor.lock()) {
+		if (executor.handle) {
+			xTaskNotifyGive(executor.handle);
 		}
+		executor.unlock();
+	}
+}
 
-		vTaskDelay(pdMS_TO_TICKS(100));
+// Sleeps until a lane worker queues a batch, then runs jobs from its own core's deque and
+// steals from the other core's until both are empty.
+void ESPTimer::executorTask(Executor &executor) {
+	Executor &other = executors_[(&executor - executors_) ^ 1];
+	while (running_.load(std::memory_order_acquire) &&
+	       (!executor.retiring.load(std::memory_order_acquire) ||
+	        !executor.retiring.exchange(false, std::memory_order_acq_rel))) {
+		CallbackJob job;
+		if (takeJob(executor, other, job)) {
+			job.run(*this, job.lane, job.entry);
+			continue;
+		}
+		ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
 	}
 
-	if (lock()) {
-		markTaskExited(Type::Min);
-		unlock();
-	} else {
-		hMin_ = nullptr;
+	parkWorker(executorBit(executor));
+}
+
+// Runs one minor frame per wakeup. vTaskDelayUntil() keeps the release times on the frame grid
+// even when a frame runs long, so an overrun shortens the next sleep instead of shifting the
+// whole schedule.
+void ESPTimer::cyclicTask() {
+	const TickType_t minorTicks = pdMS_TO_TICKS(cyclic_.minorMs);
+	const size_t frameCount = cyclic_.frameBegin.size() - 1;
+	const uint32_t budgetUs = cyclic_.minorMs * 1000;
+	TickType_t releaseTick = xTaskGetTickCount();
+	size_t frame = 0;
+	while (cyclic_.running.load(std::memory_order_acquire)) {
+		const uint32_t startUs = micros();
+		for (uint16_t k = cyclic_.frameBegin[frame]; k < cyclic_.frameBegin[frame + 1]; ++k) {
+			invokeTimerCallback(cyclic_.callbacks[cyclic_.frameTasks[k]]);
+		}
+		const uint32_t elapsedUs = micros() - startUs;
+
+		cyclic_.frames.fetch_add(1, std::memory_order_relaxed);
+		if (elapsedUs > cyclic_.maxFrameUs.load(std::memory_order_relaxed)) {
+			cyclic_.maxFrameUs.store(elapsedUs, std::memory_order_relaxed);
+		}
+		if (elapsedUs > budgetUs) {
+			cyclic_.overruns.fetch_add(1, std::memory_order_relaxed);
+			invokeTimerCallback(cyclic_.cfg.onOverrun, static_cast<uint32_t>(frame), elapsedUs);
+		}
+
+		frame = frame + 1 < frameCount ? frame + 1 : 0;
+		vTaskDelayUntil(&releaseTick, minorTicks > 0 ? minorTicks : 1);
 	}
-	vTaskDelete(nullptr);
+
+	parkWorker(kCyclicExitBit);
 }
@@ -1,50 +1,303 @@
 #pragma once
 
 #include "timer_allocator.h"
+#include "timer_chunks.h"
+#include "timer_deque.h"
+#include "timer_inbox.h"
+#include "timer_slots.h"
 #include <Arduino.h>
 #include <atomic>
 #include <freertos/FreeRTOS.h>
+#include <freertos/event_groups.h>
+#include <freertos/queue.h>
+#include <freertos/ringbuf.h>
 #include <freertos/semphr.h>
 #include <freertos/task.h>
 #include <functional>
 #include <memory>
 #include <vector>
 
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#include <coroutine>
+#define ESPTIMER_HAS_COROUTINES 1
+#endif
+
 // Public types
 enum class ESPTimerStatus : uint8_t { Invalid = 0, Running, Paused, Stopped, Completed };
 
+// Dispatch class of a timer. Callbacks that come due in the same worker pass run from the
+// highest class down, and by earliest deadline within a class.
+enum class ESPTimerPriority : uint8_t { Low = 0, Normal, High };
+
+// What set* does when a lane has no free slot (see ESPTimerConfig::admission).
+enum class ESPTimerAdmission : uint8_t { Reject = 0, EvictLow, Overflow };
+
+enum class ESPTimerLane : uint8_t { Timeouts = 0, Intervals, Counters };
+
+// One overload alarm. `value` is the number of slots in use for Occupancy, the lateness in ms
+// for Lateness, 0 for Rejected and the ID of the cleared timer for Evicted.
+struct ESPTimerOverload {
+	enum class Kind : uint8_t { Occupancy, Lateness, Rejected, Evicted };
+
+	Kind kind = Kind::Occupancy;
+	ESPTimerLane lane = ESPTimerLane::Timeouts;
+	uint8_t shard = 0;
+	uint32_t value = 0;
+};
+
 struct ESPTimerConfig {
 	// Stack sizes per task type (bytes)
 	uint16_t stackSizeTimeout = 4096 * sizeof(StackType_t);
 	uint16_t stackSizeInterval = 4096 * sizeof(StackType_t);
-	uint16_t stackSizeSec = 4096 * sizeof(StackType_t);
-	uint16_t stackSizeMs = 4096 * sizeof(StackType_t);
-	uint16_t stackSizeMin = 4096 * sizeof(StackType_t);
+	uint16_t stackSizeCounter = 0; // 0 = largest of the deprecated stackSizeSec/Ms/Min
 
 	// Priorities per task
 	UBaseType_t priorityTimeout = 1;
 	UBaseType_t priorityInterval = 1;
-	UBaseType_t prioritySec = 1;
-	UBaseType_t priorityMs = 2; // default slightly higher as it wakes up more often
-	UBaseType_t priorityMin = 1;
+	UBaseType_t priorityCounter = 0; // 0 = highest of the deprecated prioritySec/Ms/Min
 
 	// Core affinity (-1 means no pin/any core)
 	int8_t coreTimeout = -1;
 	int8_t coreInterval = -1;
+	int8_t coreCounter = -1; // -1 = first pinned of the deprecated coreMs/Sec/Min
+
+	// Deprecated: the sec/ms/min counters share the counter lane and its worker. These are only
+	// read while the matching counter field above is left at its default.
+	uint16_t stackSizeSec = 4096 * sizeof(StackType_t);
+	uint16_t stackSizeMs = 4096 * sizeof(StackType_t);
+	uint16_t stackSizeMin = 4096 * sizeof(StackType_t);
+	UBaseType_t prioritySec = 1;
+	UBaseType_t priorityMs = 2; // default slightly higher as it wakes up more often
+	UBaseType_t priorityMin = 1;
 	int8_t coreSec = -1;
 	int8_t coreMs = -1;
 	int8_t coreMin = -1;
 
+	// One scheduler shard (timeout/interval/counter lanes and workers) per CPU core. Timers
+	// belong to the shard of the core that schedules them unless a core is passed explicitly;
+	// timing changes from the other core are queued to the owner through a lock-free inbox.
+	// Workers are pinned to their shard's core and the core* fields are ignored. Capacities
+	// apply per shard. No effect on single-core chips.
+	bool shardPerCore = false;
+
+	// Run batches of fired callbacks on a work-stealing executor: the lane worker queues them on
+	// its core's deque and works through it while an executor task on the other core steals
+	// from the far end. Callbacks of one lane may then run concurrently on both cores and on
+	// any timer task's stack. No effect on single-core chips.
+	bool stealCallbacks = false;
+
+	// Stack size (bytes) and priority of the executor tasks, one pinned to each core. Only used
+	// when `stealCallbacks` is set on a dual-core chip.
+	uint16_t stackSizeExecutor = 4096 * sizeof(StackType_t);
+	UBaseType_t priorityExecutor = 1;
+
+	// Spread intervals that share a period across it instead of letting them fire together:
+	// setInterval() offsets each new interval's schedule against the existing ones of the same
+	// period (1/2, 1/4, 3/4, ... of the period). setPhasedInterval() is never adjusted.
+	bool staggerIntervals = false;
+
+	// Sort each batch of callbacks that come due in one worker pass by class and earliest
+	// deadline before running it. Turn off to run batches in slot order and skip the sort.
+	bool orderDispatch = true;
+
+	// Time budgets in µs (0 = unlimited). Once a lane's batch has run for `laneBudgetUs`, its
+	// remaining callbacks are handed back to the scan, which runs again right away with pending
+	// control calls applied; the first callback of a batch always runs. A callback that runs
+	// longer than `callbackBudgetUs` is reported to `onCallbackOverrun` with its ID, from the
+	// task that ran it.
+	uint32_t laneBudgetUs = 0;
+	uint32_t callbackBudgetUs = 0;
+	std::function<void(uint32_t id, uint32_t elapsedUs)> onCallbackOverrun;
+
+	// Admission when a lane is full: Reject makes set* return 0, EvictLow clears the Low-class
+	// timer with the most distant deadline to make room (and rejects when there is none), and
+	// Overflow admits into `overflowSlots` extra slots per lane held back for spikes.
+	ESPTimerAdmission admission = ESPTimerAdmission::Reject;
+	uint16_t overflowSlots = 0;
+
+	// High-water marks (0 = off). A lane that fills `occupancyHighWaterPct` percent of its
+	// regular slots, or a callback that starts `latenessHighWaterMs` or more after its deadline,
+	// raises one alarm per crossing. Alarms, rejections and evictions are counted in
+	// loadStats() and passed to `onOverload`, never while a lane lock is held.
+	uint8_t occupancyHighWaterPct = 0;
+	uint32_t latenessHighWaterMs = 0;
+	std::function<void(const ESPTimerOverload &overload)> onOverload;
+
 	// Prefer PSRAM-backed buffers for timer-owned dynamic containers.
 	// Falls back to default heap automatically when unavailable.
 	bool usePSRAMBuffers = false;
 
+	// Placement per storage class. `Default` follows `usePSRAMBuffers`.
+	// Slot metadata (state, IDs, deadlines) is scanned on every worker iteration, so it stays
+	// in internal RAM unless overridden. Callbacks are only touched when a timer fires.
+	ESPTimerMemoryRegion slotMemory = ESPTimerMemoryRegion::Internal;
+	ESPTimerMemoryRegion callbackMemory = ESPTimerMemoryRegion::Default;
+	ESPTimerMemoryRegion dispatchMemory = ESPTimerMemoryRegion::Default;
+
 	// Fixed slot capacities per timer type. Scheduling returns 0 when a bucket is full.
+	// Each lane holds at most 8192 slots; larger values are clamped.
 	uint16_t maxTimeouts = 16;
 	uint16_t maxIntervals = 16;
+	uint16_t maxCounters = 0; // shared by all counters; 0 = sum of the deprecated fields below
 	uint16_t maxSecCounters = 8;
 	uint16_t maxMsCounters = 8;
 	uint16_t maxMinCounters = 8;
+
+	// Elastic capacity. With `elasticChunkSlots` > 0 the max* values are starting sizes: a full
+	// lane grows by chunks of `elasticChunkSlots` (rounded up to a power of two) up to
+	// `elasticMaxSlots` per lane (0 = 8192), and chunks above the starting size are freed again
+	// after staying empty for `elasticReclaimMs`. Slots never move when a lane grows or shrinks.
+	uint16_t elasticChunkSlots = 0;
+	uint16_t elasticMaxSlots = 0;
+	uint32_t elasticReclaimMs = 1000;
+};
+
+// Bytes owned by one timer lane, split by storage class.
+struct ESPTimerLaneFootprint {
+	size_t slots = 0;
+	size_t slotBytes = 0;     // slot metadata + occupancy bitmap
+	size_t callbackBytes = 0; // std::function storage (captures beyond the SBO are not counted)
+	size_t dispatchBytes = 0; // per-iteration dispatch staging + cross-core inbox
+
+	size_t totalBytes() const {
+		return slotBytes + callbackBytes + dispatchBytes;
+	}
+};
+
+struct ESPTimerMemoryFootprint {
+	ESPTimerLaneFootprint timeouts;
+	ESPTimerLaneFootprint intervals;
+	ESPTimerLaneFootprint counters;
+	size_t executorBytes = 0; // work-stealing deques (stealCallbacks only)
+
+	size_t totalBytes() const {
+		return timeouts.totalBytes() + intervals.totalBytes() + counters.totalBytes() +
+		       executorBytes;
+	}
+};
+
+// How late callbacks of one lane started: time from the deadline to the callback's start, in
+// ms. Percentiles are the upper bound of the histogram bucket holding them (exact below 32 ms,
+// within 25% above) and never exceed `maxMs`.
+struct ESPTimerLateness {
+	uint32_t samples = 0;
+	uint32_t p50Ms = 0;
+	uint32_t p99Ms = 0;
+	uint32_t maxMs = 0;
+};
+
+struct ESPTimerLatenessStats {
+	ESPTimerLateness timeouts;
+	ESPTimerLateness intervals;
+	ESPTimerLateness counters;
+};
+
+// Overload counters of one lane since init().
+struct ESPTimerLaneLoad {
+	uint32_t peakSlots = 0;       // most slots in use at once
+	uint32_t occupancyAlarms = 0; // times the occupancy high-water mark was reached
+	uint32_t latenessAlarms = 0;  // times callbacks started crossing the lateness mark
+	uint32_t rejected = 0;        // set* calls turned away by a full lane
+	uint32_t evicted = 0;         // timers cleared by EvictLow to admit a new one
+	uint32_t overflowed = 0;      // timers admitted into overflow slots
+};
+
+struct ESPTimerLoadStats {
+	ESPTimerLaneLoad timeouts;
+	ESPTimerLaneLoad intervals;
+	ESPTimerLaneLoad counters;
+};
+
+// Fixed-size record an event timer posts instead of running a callback.
+struct ESPTimerEvent {
+	uint32_t id = 0;
+	uint32_t tag = 0;   // caller-chosen, passed through unchanged
+	uint32_t value = 0; // timeouts: 0, intervals: fires so far, counters: ticks left
+};
+
+// Where an event timer delivers its expirations. Queues (item size sizeof(ESPTimerEvent)) and
+// ring buffers receive one ESPTimerEvent per expiration; a task notification ORs `bits` into
+// the task's notification value and carries no payload. Posting never blocks: when the
+// destination is full the event is dropped and counted in droppedEvents().
+struct ESPTimerEventSink {
+	enum class Kind : uint8_t { None, Queue, RingBuffer, Notification };
+
+	Kind kind = Kind::None;
+	void *handle = nullptr;
+	uint32_t bits = 0;
+
+	static ESPTimerEventSink queue(QueueHandle_t queue) {
+		return {Kind::Queue, queue, 0};
+	}
+	static ESPTimerEventSink ringBuffer(RingbufHandle_t ring) {
+		return {Kind::RingBuffer, ring, 0};
+	}
+	static ESPTimerEventSink notify(TaskHandle_t task, uint32_t bits) {
+		return {Kind::Notification, task, bits};
+	}
+};
+
+// One entry of a cyclic executive table: `callback` runs every `periodMs`, first at `offsetMs`
+// (which must be smaller than the period) after startCyclic().
+struct ESPTimerCyclicTask {
+	uint32_t periodMs = 0;
+	uint32_t offsetMs = 0;
+	std::function<void()> callback;
+};
+
+struct ESPTimerCyclicConfig {
+	uint16_t stackSize = 4096 * sizeof(StackType_t);
+	UBaseType_t priority = configMAX_PRIORITIES - 2; // above every lane worker by default
+	int8_t core = -1;
+
+	// Called from the cyclic task after a minor frame whose callbacks ran longer than the frame.
+	std::function<void(uint32_t frame, uint32_t elapsedUs)> onOverrun;
+};
+
+struct ESPTimerCyclicStats {
+	uint32_t minorFrameMs = 0;
+	uint32_t majorFrameMs = 0;
+	uint32_t frames = 0;     // minor frames executed
+	uint32_t overruns = 0;   // frames that took longer than `minorFrameMs`
+	uint32_t maxFrameUs = 0; // longest frame so far
+};
+
+// Wait-list entry of a suspended coroutine. It lives inside the awaiter, and therefore in the
+// coroutine frame, so suspending never allocates.
+struct ESPTimerResumeNode {
+	void (*resume)(void *frame) = nullptr;
+	void *frame = nullptr;
+	ESPTimerResumeNode *next = nullptr;
+	bool fired = false;
+};
+
+class ESPTimer;
+
+// Awaitable returned by ESPTimer::sleepFor() and ESPTimer::nextTick(). `co_await` yields true
+// once the timer fired, and false when it could not be scheduled or was cleared (or the
+// instance deinitialized) first. The coroutine resumes on the worker task of the timer's lane.
+// Only usable from C++20 coroutines; the type itself compiles in any language mode.
+class ESPTimerAwaiter {
+  public:
+	bool await_ready() const noexcept {
+		return false;
+	}
+	template <typename Handle> bool await_suspend(Handle handle) noexcept;
+	bool await_resume() const noexcept {
+		return node_.fired;
+	}
+
+  private:
+	friend class ESPTimer;
+	ESPTimerAwaiter(ESPTimer &timer, uint32_t id, uint32_t delayMs, int8_t core)
+	    : timer_(&timer), id_(id), delayMs_(delayMs), core_(core) {
+	}
+
+	ESPTimer *timer_;
+	uint32_t id_;      // timer to follow, 0 for a sleep
+	uint32_t delayMs_; // sleep length
+	int8_t core_;      // shard of the sleep's timeout slot
+	ESPTimerResumeNode node_;
 };
 
 class ESPTimer {
@@ -54,20 +307,105 @@ class ESPTimer {
 
 	void init(const ESPTimerConfig &cfg = ESPTimerConfig());
 	void deinit();
+
+	// deinit() that waits at most `timeout` for the worker tasks to finish the callbacks they
+	// are running and returns true once every worker has exited; plain deinit() waits 500 ms.
+	// Workers are never deleted mid-callback: when one is still busy at the deadline, this
+	// returns false and leaves the instance deinitializing with its storage allocated, so
+	// init() fails until a later deinit() call finds every worker gone and returns true. The
+	// destructor waits for the workers without a bound.
+	bool deinit(TickType_t timeout);
+
+	// Applies `cfg` to a running instance without dropping any timer. Budgets, ordering,
+	// admission, high-water marks, staggering and the reclaim delay apply from the next
+	// callback or set* call. Priorities change in place, workers whose stack size or core
+	// changed are restarted, and lanes whose capacity changed are migrated slot by slot, so live
+	// timers keep their IDs and deadlines. Returns false without changing anything when `cfg`
+	// differs in `shardPerCore`, `stealCallbacks` or memory placement, when a live timer sits
+	// above a lane's new capacity, or when a lane is still running a callback after 500 ms; a
+	// lane a failed call cannot move back is migrated by the next call. Also returns false when
+	// a worker could not be replaced or was still in a callback after 500 ms; its type then
+	// keeps the old stack size and core. The hooks set at init() stay in place. Must not be
+	// called from a timer callback.
+	bool reconfigure(const ESPTimerConfig &cfg);
 	bool isInitialized() const {
 		return lifecycleState_.load(std::memory_order_acquire) == LifecycleState::Initialized;
 	}
 
-	// Scheduling
-	uint32_t setTimeout(std::function<void()> cb, uint32_t delayMs);
-	uint32_t setInterval(std::function<void()> cb, uint32_t periodMs);
+	// Scheduling. `core` picks the owning shard when `shardPerCore` is set (-1 = caller's core).
+	uint32_t setTimeout(std::function<void()> cb, uint32_t delayMs, int8_t core = -1);
+	uint32_t setInterval(std::function<void()> cb, uint32_t periodMs, int8_t core = -1);
+
+	// setInterval() with every fire shifted by `phaseMs` (modulo the period), so the first call
+	// comes `periodMs + phaseMs % periodMs` after scheduling.
+	uint32_t setPhasedInterval(
+	    std::function<void()> cb,
+	    uint32_t periodMs,
+	    uint32_t phaseMs,
+	    int8_t core = -1
+	);
+
+	// Counters tick every `tickMs` until `totalMs` has elapsed and pass the number of ticks
+	// left, rounded up, so the final call receives 0. All counters share one lane and worker,
+	// which sleeps until the nearest tick. Returns 0 when `tickMs` is 0.
+	uint32_t setCounter(
+	    std::function<void(uint32_t ticksLeft)> cb,
+	    uint32_t totalMs,
+	    uint32_t tickMs,
+	    int8_t core = -1
+	);
+
+	// Fixed-tick wrappers around setCounter(); their IDs work with every *Counter call.
+	// setMsCounter() always reports milliseconds left but calls back at most once every
+	// `minIntervalMs`; the final call at the deadline is never skipped.
 	uint32_t setSecCounter(std::function<void(int secLeft)> cb, uint32_t totalMs);
-	uint32_t setMsCounter(std::function<void(uint32_t msLeft)> cb, uint32_t totalMs);
+	uint32_t setMsCounter(
+	    std::function<void(uint32_t msLeft)> cb,
+	    uint32_t totalMs,
+	    uint32_t minIntervalMs = 1
+	);
 	uint32_t setMinCounter(std::function<void(int minLeft)> cb, uint32_t totalMs);
 
+	// Adaptive ms counter: the callback returns how many ms until it wants to be called again
+	// (0 means 1 ms). The first call comes after 1 ms and the final call at the deadline.
+	uint32_t setAdaptiveMsCounter(std::function<uint32_t(uint32_t msLeft)> cb, uint32_t totalMs);
+
+	// Event timers post an ESPTimerEvent to `sink` straight from the worker's scan instead of
+	// running a callback, so expirations reach another task in one hop with no in-flight
+	// tracking. Their IDs work with every control call of the matching type. Counter events
+	// carry the ticks left, like setCounter().
+	uint32_t setTimeoutEvent(
+	    const ESPTimerEventSink &sink,
+	    uint32_t tag,
+	    uint32_t delayMs,
+	    int8_t core = -1
+	);
+	uint32_t setIntervalEvent(
+	    const ESPTimerEventSink &sink,
+	    uint32_t tag,
+	    uint32_t periodMs,
+	    int8_t core = -1
+	);
+	uint32_t setCounterEvent(
+	    const ESPTimerEventSink &sink,
+	    uint32_t tag,
+	    uint32_t totalMs,
+	    uint32_t tickMs,
+	    int8_t core = -1
+	);
+	// Events lost to full queues or ring buffers since init().
+	uint32_t droppedEvents() const {
+		return droppedEvents_.load(std::memory_order_relaxed);
+	}
+
+	// Control calls. With `shardPerCore`, a call from a core other than the timer's owner is
+	// queued to the owning shard and applied on its next pass; it then returns true if the ID
+	// was live when queued. Calls on the owning core apply immediately as documented below.
+
 	// Pause: set status to Paused if currently Running; returns true on state change
 	bool pauseTimer(uint32_t id);
 	bool pauseInterval(uint32_t id);
+	bool pauseCounter(uint32_t id);
 	bool pauseSecCounter(uint32_t id);
 	bool pauseMsCounter(uint32_t id);
 	bool pauseMinCounter(uint32_t id);
@@ -75,6 +413,7 @@ class ESPTimer {
 	// Resume: set status to Running if currently Paused; returns true on state change
 	bool resumeTimer(uint32_t id);
 	bool resumeInterval(uint32_t id);
+	bool resumeCounter(uint32_t id);
 	bool resumeSecCounter(uint32_t id);
 	bool resumeMsCounter(uint32_t id);
 	bool resumeMinCounter(uint32_t id);
@@ -82,6 +421,7 @@ class ESPTimer {
 	// Toggle running status between Running <-> Paused; returns true if now Running
 	bool toggleRunStatusTimer(uint32_t id);
 	bool toggleRunStatusInterval(uint32_t id);
+	bool toggleRunStatusCounter(uint32_t id);
 	bool toggleRunStatusSecCounter(uint32_t id);
 	bool toggleRunStatusMsCounter(uint32_t id);
 	bool toggleRunStatusMinCounter(uint32_t id);
@@ -89,15 +429,89 @@ class ESPTimer {
 	// Clear (stop and remove) timers; returns true on success
 	bool clearTimeout(uint32_t id);
 	bool clearInterval(uint32_t id);
+	bool clearCounter(uint32_t id);
 	bool clearSecCounter(uint32_t id);
 	bool clearMsCounter(uint32_t id);
 	bool clearMinCounter(uint32_t id);
 
-	// Status
+	// Re-arm in place: the slot, callback and ID are kept and only the deadline moves.
+	// restartTimeout() restarts the countdown with the current delay, rescheduleTimeout()
+	// replaces the delay first. Both work from inside the timeout's own callback and keep a
+	// paused timeout paused. setIntervalPeriod() takes effect from the last fire.
+	// Return false for unknown, cleared or completed IDs.
+	bool restartTimeout(uint32_t id);
+	bool rescheduleTimeout(uint32_t id, uint32_t newDelayMs);
+	bool setIntervalPeriod(uint32_t id, uint32_t newPeriodMs);
+
+	// Debounce/throttle handles are timeout slots that stay allocated between triggers, so
+	// triggering never allocates, moves a callback or hands out a new ID. An idle handle reports
+	// Completed and a pending one Running; release a handle with clearTimeout().
+	// debounce() (re)starts the countdown, so the callback runs once `delayMs` after the last
+	// trigger of a burst. throttle() runs the callback at most once per `periodMs`: a trigger in
+	// an open window fires right away, triggers inside the window collapse into one call at its
+	// end. Both return false for IDs that are not debounce/throttle handles.
+	uint32_t setDebounce(std::function<void()> cb, uint32_t delayMs);
+	uint32_t setThrottle(std::function<void()> cb, uint32_t periodMs);
+	bool debounce(uint32_t id);
+	bool throttle(uint32_t id);
+
+	// Cyclic executive: a fixed table of periodic callbacks compiled at start into minor frames
+	// (gcd of all periods and offsets) repeating every major frame (lcm of the periods). One
+	// task wakes at each frame boundary and runs that frame's callbacks in table order, so
+	// nothing is scanned per tick and the order never varies. Needs an initialized instance;
+	// returns false when the table is empty or invalid, the minor frame is not a whole number
+	// of RTOS ticks, the schedule exceeds 4096 frames, or a table is already running. deinit()
+	// stops it.
+	bool startCyclic(
+	    const ESPTimerCyclicTask *tasks,
+	    size_t count,
+	    const ESPTimerCyclicConfig &cfg = {}
+	);
+	template <size_t N>
+	bool startCyclic(const ESPTimerCyclicTask (&tasks)[N], const ESPTimerCyclicConfig &cfg = {}) {
+		return startCyclic(tasks, N, cfg);
+	}
+	void stopCyclic();
+	ESPTimerCyclicStats cyclicStats() const;
+
+	// Blocks the calling task until the timer's next callback has returned (or its next event
+	// was posted) and returns true; a one-shot counts as fired once it completes. Returns false
+	// on timeout, for unknown IDs, when the timer is cleared or deinit() runs while waiting, and
+	// when another task is already waiting on the same timer. The wake-up is a direct task
+	// notification from the worker using bits 30 and 31 of the caller's notification value, so
+	// nothing polls or allocates. Do not wait on a timer from one of its own callbacks.
+	bool waitFor(uint32_t id, TickType_t timeoutTicks = portMAX_DELAY);
+
+	// Coroutine awaitables (C++20): `co_await timer.sleepFor(ms)` suspends the coroutine on a
+	// timeout slot and `co_await timer.nextTick(id)` until the next fire of any existing timer.
+	// The resume hook is stored in the slot pools, so awaiting never allocates and any number of
+	// coroutines share the worker's stack. Awaiters of a cleared timer resume with false on
+	// the lane worker's next pass; deinit() resumes the remaining ones with false on its caller.
+	ESPTimerAwaiter sleepFor(uint32_t delayMs, int8_t core = -1);
+	ESPTimerAwaiter nextTick(uint32_t id);
+
+	// Moves a timer of any type to another priority class (new timers start as Normal). Takes
+	// effect from the next worker pass; returns false for unknown or cleared IDs.
+	bool setPriority(uint32_t id, ESPTimerPriority priority);
+
+	// Status. Lock-free: safe to poll from any task at high rate.
 	ESPTimerStatus getStatus(uint32_t id);
+	bool isRunning(uint32_t id);
+
+	// Bytes reserved per lane for the current configuration; all zero before init().
+	ESPTimerMemoryFootprint memoryFootprint() const;
+
+	// Start lateness of dispatched callbacks per lane type, summed over shards, since init() or
+	// the last resetLatenessStats(). Lock-free; event timers and coroutines are not sampled.
+	ESPTimerLatenessStats latenessStats() const;
+	void resetLatenessStats();
+
+	// Occupancy peaks, high-water alarms and admission decisions per lane type, summed over
+	// shards (peaks are the largest shard's). Lock-free.
+	ESPTimerLoadStats loadStats() const;
 
   private:
-	enum class Type : uint8_t { Timeout, Interval, Sec, Ms, Min };
+	enum class Type : uint8_t { Timeout, Interval, Counter };
 	enum class LifecycleState : uint8_t {
 		Uninitialized,
 		Initializing,
@@ -105,134 +519,606 @@ class ESPTimer {
 		Deinitializing
 	};
 
+	// Timer IDs encode the owning lane and shard, a per-slot generation and the slot index, so
+	// lookups are a direct index and stale IDs are rejected once their slot has been reused.
+	// Layout: [31:30] lane, [29] shard, [28:13] generation (never 0), [12:0] slot index.
+	static constexpr uint32_t kIdIndexBits = 13;
+	static constexpr uint32_t kIdGenerationBits = 16;
+	static constexpr uint32_t kIdShardShift = kIdIndexBits + kIdGenerationBits;
+	static constexpr uint32_t kIdTypeShift = kIdShardShift + 1;
+	static constexpr uint16_t kMaxSlotsPerLane = 1u << kIdIndexBits;
+	static constexpr uint8_t kMaxShards = 2;
+
+	// Exit bits in `exited_`: three lane workers per shard, then one per executor, then the
+	// cyclic task.
+	static constexpr EventBits_t kLaneExitBits = (1u << (kMaxShards * 3)) - 1;
+	static constexpr EventBits_t kExecutorExitBits = ((1u << kMaxShards) - 1) << (kMaxShards * 3);
+	static constexpr EventBits_t kCyclicExitBit = 1u << (kMaxShards * 4);
+	static constexpr uint32_t kJoinTimeoutMs = 500;
+
+	// Notification bits waitFor() reserves in the waiting task's notification value.
+	static constexpr uint32_t kWaitFiredBit = 1u << 31;
+	static constexpr uint32_t kWaitEndedBit = 1u << 30;
+
+	// Longest sleep of the counter worker when no running counter ticks sooner.
+	static constexpr uint32_t kCounterIdleWaitMs = 100;
+
+	// Lateness histogram: one bucket per ms below kLatenessLinearMs, then four per power of two
+	// up to 8 s; the last bucket also takes everything beyond.
+	static constexpr uint32_t kLatenessLinearMs = 32;
+	static constexpr uint32_t kLatenessBuckets = kLatenessLinearMs + 8 * 4 + 1;
+
+	// Slot state word: the slot generation in the high half, ESPTimerStatus, the in-flight
+	// dispatch flag, the re-armed-while-in-flight flag, the persistent-handle, event and waiter
+	// flags in the low byte and the ESPTimerPriority class above them. The timer type is implied
+	// by the lane that owns the slot. The word is only modified under the lock but published
+	// atomically, so getStatus() and isRunning() read it without locking. Items are only copied
+	// while the lock is held.
 	struct BaseItem {
-		bool active = false;
-		bool executing = false;
-		uint32_t id = 0;
-		ESPTimerStatus status = ESPTimerStatus::Invalid;
-		Type type = Type::Timeout;
-		uint32_t createdMs = 0;
+		static constexpr uint32_t kStatusMask = 0x07;
+		static constexpr uint32_t kExecutingBit = 0x08;
+		static constexpr uint32_t kRearmedBit = 0x10;
+		static constexpr uint32_t kPersistentBit = 0x20;
+		static constexpr uint32_t kEventBit = 0x40;
+		static constexpr uint32_t kWaiterBit = 0x80;
+		static constexpr uint32_t kPriorityShift = 8;
+		static constexpr uint32_t kPriorityMask = 0x3u << kPriorityShift;
+		static constexpr uint32_t kGenerationShift = 16;
+
+		std::atomic<uint32_t> word{0};
+
+		BaseItem() = default;
+		BaseItem(const BaseItem &other) : word(other.word.load(std::memory_order_relaxed)) {
+		}
+		BaseItem &operator=(const BaseItem &other) {
+			publish(other.word.load(std::memory_order_relaxed));
+			return *this;
+		}
+
+		uint16_t generation() const {
+			return static_cast<uint16_t>(word.load(std::memory_order_relaxed) >> kGenerationShift);
+		}
+		ESPTimerStatus status() const {
+			return static_cast<ESPTimerStatus>(word.load(std::memory_order_relaxed) & kStatusMask);
+		}
+		bool executing() const {
+			return (word.load(std::memory_order_relaxed) & kExecutingBit) != 0;
+		}
+		bool rearmed() const {
+			return (word.load(std::memory_order_relaxed) & kRearmedBit) != 0;
+		}
+		bool persistent() const {
+			return (word.load(std::memory_order_relaxed) & kPersistentBit) != 0;
+		}
+		bool postsEvents() const {
+			return (word.load(std::memory_order_relaxed) & kEventBit) != 0;
+		}
+		bool hasWaiter() const {
+			return (word.load(std::memory_order_relaxed) & kWaiterBit) != 0;
+		}
+		uint8_t priority() const {
+			return static_cast<uint8_t>(
+			    (word.load(std::memory_order_relaxed) & kPriorityMask) >> kPriorityShift
+			);
+		}
+		void setStatus(ESPTimerStatus status) {
+			const uint32_t current = word.load(std::memory_order_relaxed);
+			publish((current & ~kStatusMask) | static_cast<uint32_t>(status));
+		}
+		void setExecuting(bool executing) {
+			const uint32_t current = word.load(std::memory_order_relaxed);
+			publish(executing ? (current | kExecutingBit) : (current & ~kExecutingBit));
+		}
+		void setRearmed(bool rearmed) {
+			const uint32_t current = word.load(std::memory_order_relaxed);
+			publish(rearmed ? (current | kRearmedBit) : (current & ~kRearmedBit));
+		}
+		void setPersistent(bool persistent) {
+			const uint32_t current = word.load(std::memory_order_relaxed);
+			publish(persistent ? (current | kPersistentBit) : (current & ~kPersistentBit));
+		}
+		void setPostsEvents() {
+			publish(word.load(std::memory_order_relaxed) | kEventBit);
+		}
+		void setWaiter(bool waiting) {
+			const uint32_t current = word.load(std::memory_order_relaxed);
+			publish(waiting ? (current | kWaiterBit) : (current & ~kWaiterBit));
+		}
+		void setPriority(ESPTimerPriority priority) {
+			const uint32_t current = word.load(std::memory_order_relaxed) & ~kPriorityMask;
+			publish(current | (static_cast<uint32_t>(priority) << kPriorityShift));
+		}
+		void publish(uint32_t value) {
+			word.store(value, std::memory_order_release);
+		}
 	};
 
 	struct TimeoutItem : BaseItem {
-		std::function<void()> cb;
+		using Callback = std::function<void()>;
 		uint32_t dueAtMs = 0;
+		uint32_t delayMs = 0;
 	};
 
+	// `lastFireMs` may lie in the future to carry a phase offset; the next fire is always due at
+	// `lastFireMs + periodMs`.
 	struct IntervalItem : BaseItem {
-		std::function<void()> cb;
+		using Callback = std::function<void()>;
 		uint32_t periodMs = 0;
 		uint32_t lastFireMs = 0;
 	};
 
-	struct SecItem : BaseItem {
-		std::function<void(int)> cb;
-		uint32_t endAtMs = 0;
-		uint32_t lastTickMs = 0;
-	};
+	// How a counter reports progress: remaining ticks, remaining ms at a capped rate, or
+	// remaining ms with the next interval chosen by the callback's return value.
+	enum class CounterMode : uint8_t { Ticks, Milliseconds, Adaptive };
 
-	struct MsItem : BaseItem {
-		std::function<void(uint32_t)> cb;
+	// Counter callbacks return the adaptive interval; other modes ignore the result.
+	// `nextTickMs` is precomputed from `endAtMs` (see nextCounterTick()) and never later than it.
+	struct CounterItem : BaseItem {
+		using Callback = std::function<uint32_t(uint32_t)>;
 		uint32_t endAtMs = 0;
-		uint32_t lastTickMs = 0;
+		uint32_t nextTickMs = 0;
+		uint32_t tickMs = 0;
+		CounterMode mode = CounterMode::Ticks;
 	};
 
-	struct MinItem : BaseItem {
-		std::function<void(int)> cb;
-		uint32_t endAtMs = 0;
-		uint32_t lastTickMs = 0;
+	// Staged fires carry their class and the deadline the scan found expired, so a batch can be
+	// ordered without touching the slots again (see orderBatch()). `deferred` marks entries the
+	// lane budget handed back to the scan (see deferDispatchLocked()).
+	struct TimedDispatch {
+		uint16_t index = 0;
+		uint8_t priority = 0;
+		bool deferred = false;
+		uint32_t dueAtMs = 0;
 	};
 
-	struct TimedDispatch {
-		size_t index = 0;
+	struct CounterDispatch {
+		uint16_t index = 0;
+		uint8_t priority = 0;
+		bool deferred = false;
+		uint32_t dueAtMs = 0;
+		uint32_t arg = 0;
+		uint32_t nextMs = 0;
 	};
 
-	struct SecDispatch {
-		size_t index = 0;
-		int arg = 0;
+	// Every state change an API call can make on an existing timer. Applied under the lane lock,
+	// either directly or by the owning shard's worker when a timing change is posted from the
+	// other core.
+	enum class ControlOp : uint8_t {
+		Pause,
+		Resume,
+		Toggle,
+		Clear,
+		Restart,
+		Reschedule,
+		SetPeriod,
+		Debounce,
+		Throttle,
+		SetPriority
 	};
 
-	struct MsDispatch {
-		size_t index = 0;
+	struct ControlCommand {
+		uint32_t id = 0;
 		uint32_t arg = 0;
+		ControlOp op = ControlOp::Pause;
+	};
+
+	// Delivery target of an event timer slot (cold storage next to the callbacks).
+	struct EventTarget {
+		ESPTimerEventSink sink;
+		uint32_t tag = 0;
+		uint32_t fires = 0;
 	};
 
-	struct MinDispatch {
-		size_t index = 0;
-		int arg = 0;
+	struct Waiters {
+		TaskHandle_t task = nullptr;
+		ESPTimerResumeNode *coroutines = nullptr;
 	};
 
-	// Storage per type
-	TimerVector<TimeoutItem> timeouts_;
-	TimerVector<IntervalItem> intervals_;
-	TimerVector<SecItem> secs_;
-	TimerVector<MsItem> mss_;
-	TimerVector<MinItem> mins_;
+	// Overload accounting of one lane. `crowded` and `late` remember which side of each
+	// high-water mark the lane is on, so a crossing alarms once.
+	struct LaneLoad {
+		std::atomic<uint32_t> peakSlots{0};
+		std::atomic<uint32_t> occupancyAlarms{0};
+		std::atomic<uint32_t> latenessAlarms{0};
+		std::atomic<uint32_t> rejected{0};
+		std::atomic<uint32_t> evicted{0};
+		std::atomic<uint32_t> overflowed{0};
+		std::atomic<bool> crowded{false};
+		std::atomic<bool> late{false};
+	};
+
+	// Alarms raised under a lane lock, reported once it is released.
+	struct OverloadNotice {
+		ESPTimerOverload alarms[2];
+		uint8_t count = 0;
+
+		void add(const ESPTimerOverload &alarm) {
+			if (count < 2) {
+				alarms[count++] = alarm;
+			}
+		}
+	};
+
+	// Slot pool for one timer type. `slots` tracks occupancy so allocation, release and scans
+	// never walk free entries. The per-slot pools are chunked: fixed lanes use one chunk, elastic
+	// lanes add chunks as they fill (see growLaneLocked()) and give idle ones back, never below
+	// `baseChunks`; `retiredGeneration` carries slot generations across a reclaim. Hot metadata
+	// (`items`, `slots`) and cold callback storage live in separate buffers so each can be
+	// placed in its own memory region.
+	// Every lane has its own mutex, so lanes and the API calls that target them never contend
+	// with each other; `mutex_` only serializes lifecycle transitions. `inbox` carries control
+	// calls from the other core and is drained by the lane's worker (sharded mode only).
+	// `events` holds the sink of each event timer slot and `waiters` the task blocked in
+	// waitFor() and the coroutines suspended on a slot, valid while its waiter flag is set.
+	// Fired or cancelled coroutines collect in `resumable` until the worker resumes them
+	// outside the lock. `lateness` is updated without the lock, because stolen callbacks start
+	// on other tasks, and outlives init()/deinit(). `batchStartUs` is set by the worker before
+	// each batch runs and read by every task that runs part of it. Slots beyond `regularSlots`
+	// are overflow slots, only handed out by the Overflow admission policy. While `exclusive`
+	// is set, lock-free status reads and cross-core posts take the lane lock instead, so
+	// reconfigure() can replace the pools and restart the worker under it.
+	template <typename Item, typename Dispatch> struct Lane {
+		SemaphoreHandle_t mutex = nullptr;
+		TimerChunkedVector<Item> items;
+		TimerSlotBitmap slots;
+		TimerChunkedVector<typename Item::Callback> callbacks;
+		TimerChunkedVector<EventTarget> events;
+		TimerChunkedVector<Waiters> waiters;
+		TimerVector<Dispatch> dispatch;
+		TimerInbox<ControlCommand> inbox;
+		// Work-stealing batches: staged jobs not yet finished plus one reference held by the
+		// lane worker. Whoever drops it to zero other than the worker gives `batchDone`.
+		std::atomic<uint16_t> pendingJobs{0};
+		SemaphoreHandle_t batchDone = nullptr;
+		ESPTimerResumeNode *resumable = nullptr;
+		std::atomic<uint32_t> lateness[kLatenessBuckets] = {};
+		std::atomic<uint32_t> maxLatenessMs{0};
+		uint32_t batchStartUs = 0;
+		uint8_t shard = 0;
+		uint16_t regularSlots = 0;
+		uint16_t sizedSlots = 0;      // max* value the pools were built for
+		uint16_t sizedChunkSlots = 0; // elasticChunkSlots they were built with
+		uint16_t baseChunks = 0;
+		uint16_t retiredGeneration = 0;
+		bool topChunkIdle = false;
+		uint32_t topChunkIdleSinceMs = 0;
+		std::atomic<bool> exclusive{false};
+		LaneLoad load;
+
+		bool lock() const {
+			return mutex && xSemaphoreTake(mutex, portMAX_DELAY) == pdTRUE;
+		}
+		void unlock() const {
+			if (mutex) {
+				xSemaphoreGive(mutex);
+			}
+		}
+	};
+
+	// One scheduler: a lane per timer type plus its workers. Shard 0 is always active; shard 1
+	// only with `shardPerCore` on dual-core chips. Workers receive their shard as task argument.
+	// `retiring` holds one bit per Type; a worker takes its bit and exits after its current pass,
+	// unless reconfigure() takes it back first.
+	struct Shard {
+		ESPTimer *owner = nullptr;
+		Lane<TimeoutItem, TimedDispatch> timeouts;
+		Lane<IntervalItem, TimedDispatch> intervals;
+		Lane<CounterItem, CounterDispatch> counters;
+		TaskHandle_t hTimeout = nullptr;
+		TaskHandle_t hInterval = nullptr;
+		TaskHandle_t hCounter = nullptr;
+		std::atomic<uint8_t> retiring{0};
+	};
+
+	Shard shards_[kMaxShards];
+	std::atomic<uint8_t> shardCount_{1};
+
+	// One staged callback: `run` invokes dispatch entry `entry` of the lane behind `lane`.
+	struct CallbackJob {
+		void (*run)(ESPTimer &timer, void *lane, uint16_t entry) = nullptr;
+		void *lane = nullptr;
+		uint16_t entry = 0;
+	};
+
+	// Per-core job deque and the executor task pinned to that core (stealCallbacks only).
+	struct Executor {
+		ESPTimer *owner = nullptr;
+		SemaphoreHandle_t mutex = nullptr;
+		TimerDeque<CallbackJob> jobs;
+		TaskHandle_t handle = nullptr;
+		std::atomic<bool> retiring{false};
+
+		bool lock() const {
+			return mutex && xSemaphoreTake(mutex, portMAX_DELAY) == pdTRUE;
+		}
+		void unlock() const {
+			if (mutex) {
+				xSemaphoreGive(mutex);
+			}
+		}
+	};
+
+	Executor executors_[kMaxShards];
+	std::atomic<uint8_t> executorCount_{0};
+
+	static constexpr uint32_t kMaxCyclicFrames = 4096;
+
+	// Precomputed cyclic executive. Frame `f` runs `frameTasks[frameBegin[f]..frameBegin[f+1])`.
+	// Guarded by `mutex_` except for the fields the cyclic task updates while running.
+	struct Cyclic {
+		TimerVector<IntervalItem::Callback> callbacks;
+		TimerVector<uint16_t> frameBegin;
+		TimerVector<uint16_t> frameTasks;
+		ESPTimerCyclicConfig cfg;
+		uint32_t minorMs = 0;
+		uint32_t majorMs = 0;
+		bool active = false;
+		TaskHandle_t handle = nullptr;
+		std::atomic<bool> running{false};
+		std::atomic<uint32_t> frames{0};
+		std::atomic<uint32_t> overruns{0};
+		std::atomic<uint32_t> maxFrameUs{0};
+	};
 
-	TimerVector<TimedDispatch> timeoutDispatch_;
-	TimerVector<TimedDispatch> intervalDispatch_;
-	TimerVector<SecDispatch> secDispatch_;
-	TimerVector<MsDispatch> msDispatch_;
-	TimerVector<MinDispatch> minDispatch_;
+	Cyclic cyclic_;
 
 	// FreeRTOS bits
 	mutable SemaphoreHandle_t mutex_ = nullptr;
-	TaskHandle_t hTimeout_ = nullptr;
-	TaskHandle_t hInterval_ = nullptr;
-	TaskHandle_t hSec_ = nullptr;
-	TaskHandle_t hMs_ = nullptr;
-	TaskHandle_t hMin_ = nullptr;
+	// One bit per worker task, set by the task right before it parks for joinWorkers() to delete
+	// it and cleared when it is created; workers that do not exist read as exited (see
+	// workerBit()).
+	EventGroupHandle_t exited_ = nullptr;
+
+	// Settings that reconfigure() may change while workers, executors and set* calls read them
+	// without `mutex_`. `cfg_` is only read under `mutex_`, except for the hooks, which never
+	// change after init().
+	struct Tunables {
+		std::atomic<bool> staggerIntervals{false};
+		std::atomic<bool> orderDispatch{true};
+		std::atomic<uint32_t> laneBudgetUs{0};
+		std::atomic<uint32_t> callbackBudgetUs{0};
+		std::atomic<ESPTimerAdmission> admission{ESPTimerAdmission::Reject};
+		std::atomic<uint8_t> occupancyHighWaterPct{0};
+		std::atomic<uint32_t> latenessHighWaterMs{0};
+		std::atomic<uint32_t> elasticReclaimMs{0};
+
+		void store(const ESPTimerConfig &cfg);
+	};
 
 	ESPTimerConfig cfg_{};
+	Tunables tunables_;
+	// Set under `mutex_` when deinit() ran out of time with a worker still running.
+	bool shutdownPending_ = false;
 	std::atomic<bool> running_{false};
 	std::atomic<LifecycleState> lifecycleState_{LifecycleState::Uninitialized};
-	uint32_t nextId_ = 1;
-	bool usePSRAMBuffers_ = false;
+	std::atomic<uint32_t> lockFreeUsers_{0};
+	std::atomic<uint32_t> droppedEvents_{0};
+	ESPTimerMemoryRegion slotRegion_ = ESPTimerMemoryRegion::Default;
+	ESPTimerMemoryRegion callbackRegion_ = ESPTimerMemoryRegion::Default;
+	ESPTimerMemoryRegion dispatchRegion_ = ESPTimerMemoryRegion::Default;
 
 	bool lock() const;
 	void unlock() const;
-	uint32_t nextIdLocked();
 
 	// Task loops
 	static void timeoutTaskTrampoline(void *arg);
 	static void intervalTaskTrampoline(void *arg);
-	static void secTaskTrampoline(void *arg);
-	static void msTaskTrampoline(void *arg);
-	static void minTaskTrampoline(void *arg);
+	static void counterTaskTrampoline(void *arg);
+	static void executorTaskTrampoline(void *arg);
+	static void cyclicTaskTrampoline(void *arg);
 
-	void timeoutTask();
-	void intervalTask();
-	void secTask();
-	void msTask();
-	void minTask();
+	void timeoutTask(Shard &shard);
+	void intervalTask(Shard &shard);
+	void counterTask(Shard &shard);
+	void executorTask(Executor &executor);
+	void cyclicTask();
+	bool buildCyclicLocked(const ESPTimerCyclicTask *tasks, size_t count);
+	void releaseCyclicLocked();
 
 	// Helpers
 	bool configureStorageLocked();
+	size_t jobCapacity() const;
+	bool resizeJobDequesLocked();
 	void releaseStorageLocked();
-	void waitForWorkerExit(TaskHandle_t &handle);
-	void markTaskExited(Type type);
+	bool createShardWorkersLocked(Shard &shard);
+	bool createWorkerLocked(Shard &shard, Type type, const ESPTimerConfig &cfg);
+	bool createExecutorsLocked();
+	EventBits_t workerBit(const Shard &shard, Type type) const;
+	EventBits_t executorBit(const Executor &executor) const;
+	bool joinWorkers(EventBits_t bits, TickType_t timeout);
+	bool stopCyclic(TickType_t timeout);
+	bool workerActive(Shard &shard, Type type);
+	void parkWorker(EventBits_t exitBit);
+	static TaskHandle_t &workerHandle(Shard &shard, Type type);
+	bool restartWorkersLocked(const ESPTimerConfig &previous);
+	template <typename Item, typename Dispatch>
+	bool resizeLane(
+	    Lane<Item, Dispatch> &lane,
+	    const ESPTimerConfig &cfg,
+	    uint16_t regularSlots,
+	    TickType_t timeout
+	);
+	template <typename Item, typename Dispatch>
+	static bool laneMatches(
+	    const Lane<Item, Dispatch> &lane,
+	    const ESPTimerConfig &cfg,
+	    uint16_t regularSlots
+	);
+	template <typename Item, typename Dispatch>
+	bool laneFits(const Lane<Item, Dispatch> &lane, uint16_t capacity) const;
+	void wakeCounterWorkerLocked(Shard &shard);
+	Shard &shardFor(int8_t core);
+	uint8_t shardIndex(const Shard &shard) const {
+		return static_cast<uint8_t>(&shard - shards_);
+	}
+	uint8_t currentShard() const;
+	uint32_t createTimeout(
+	    std::function<void()> cb,
+	    uint32_t delayMs,
+	    bool persistent,
+	    int8_t core,
+	    const EventTarget *event = nullptr,
+	    ESPTimerResumeNode *resume = nullptr
+	);
+	uint32_t createInterval(
+	    std::function<void()> cb,
+	    uint32_t periodMs,
+	    bool explicitPhase,
+	    uint32_t phaseMs,
+	    int8_t core,
+	    const EventTarget *event = nullptr
+	);
+	uint32_t staggeredPhaseLocked(
+	    const Lane<IntervalItem, TimedDispatch> &lane,
+	    uint32_t periodMs,
+	    uint32_t now
+	) const;
+	uint32_t createCounter(
+	    CounterItem::Callback cb,
+	    uint32_t totalMs,
+	    uint32_t tickMs,
+	    CounterMode mode,
+	    int8_t core,
+	    const EventTarget *event = nullptr
+	);
 	bool tryCreateWorkerLocked(
 	    TaskFunction_t fn,
 	    const char *name,
 	    uint16_t stack,
 	    UBaseType_t prio,
 	    int8_t core,
-	    TaskHandle_t &handle
+	    void *arg,
+	    TaskHandle_t &handle,
+	    EventBits_t exitBit
 	);
 	ESPTimerConfig normalizeConfig(const ESPTimerConfig &cfg) const;
-	ESPTimerStatus getStatusLocked(uint32_t id) const;
+	static void foldLegacyCounterFields(ESPTimerConfig &cfg);
+	ESPTimerMemoryRegion resolveRegion(ESPTimerMemoryRegion region) const;
+
+	static uint32_t makeId(Type type, uint8_t shard, uint16_t generation, size_t index);
+	static bool
+	decodeId(uint32_t id, Type &type, uint8_t &shard, uint16_t &generation, size_t &index);
+	static bool deadlineReached(uint32_t now, uint32_t deadline);
+	static uint32_t nextCounterTick(const CounterItem &item, uint32_t now);
+	template <typename Item> static uint32_t nextDeadline(const Item &item);
+	template <typename Item> static constexpr Type laneType();
 
-	template <typename Item> void resetItem(Item &item, Type type);
-	template <typename Item> Item *findItemById(TimerVector<Item> &vec, uint32_t id);
-	template <typename Item>
-	const Item *findItemById(const TimerVector<Item> &vec, uint32_t id) const;
-	template <typename Item> Item *findFreeSlot(TimerVector<Item> &vec);
-	template <typename Item> void clearStoppedLocked(TimerVector<Item> &vec, Type type);
+	template <typename Item> void resetItem(Item &item);
+	template <typename Item, typename Dispatch>
+	bool configureLane(Lane<Item, Dispatch> &lane, uint16_t regularSlots, bool withInbox);
+	static uint16_t laneLimit(const ESPTimerConfig &cfg, uint16_t regularSlots);
+	static uint16_t laneCapacity(const ESPTimerConfig &cfg, uint16_t regularSlots);
+	template <typename Item, typename Dispatch> void releaseLane(Lane<Item, Dispatch> &lane);
+	template <typename Fn> void forEachLane(Fn &&fn);
+	template <typename Fn> bool withLaneLocked(Shard &shard, Type type, Fn &&fn);
+	template <typename Item, typename Dispatch>
+	Item *findItemById(Lane<Item, Dispatch> &lane, uint32_t id, size_t &index);
+	template <typename Item, typename Dispatch>
+	Item *acquireSlotLocked(Lane<Item, Dispatch> &lane, size_t &index, OverloadNotice &notice);
+	template <typename Item, typename Dispatch>
+	bool admitLocked(Lane<Item, Dispatch> &lane, OverloadNotice &notice);
+	template <typename Item, typename Dispatch> void resetStagingLocked(Lane<Item, Dispatch> &lane);
+	template <typename Item, typename Dispatch> bool growLaneLocked(Lane<Item, Dispatch> &lane);
+	template <typename Item, typename Dispatch>
+	Item *reclaimChunkLocked(Lane<Item, Dispatch> &lane, uint32_t now);
+	template <typename Item, typename Dispatch>
+	void releaseChunk(Lane<Item, Dispatch> &lane, Item *chunk);
+	template <typename Item, typename Dispatch>
+	bool aboveOccupancyMark(const Lane<Item, Dispatch> &lane) const;
+	void reportOverload(const OverloadNotice &notice) const;
+	template <typename Item, typename Dispatch>
+	void releaseSlotLocked(Lane<Item, Dispatch> &lane, size_t index);
+	template <typename Item, typename Dispatch>
+	bool dispatchBatch(Lane<Item, Dispatch> &lane, bool oneShot);
+	template <typename Item, typename Dispatch>
+	void deferDispatchLocked(Lane<Item, Dispatch> &lane, const Dispatch &dispatch);
+	template <typename Dispatch> static void orderBatch(TimerVector<Dispatch> &batch);
+	template <typename Item, typename Dispatch>
+	void postEventLocked(
+	    Lane<Item, Dispatch> &lane,
+	    uint8_t shard,
+	    size_t index,
+	    uint32_t value,
+	    bool last
+	);
+	template <typename Item, typename Dispatch>
+	void wakeWaiterLocked(Lane<Item, Dispatch> &lane, size_t index, uint32_t bit);
+	template <typename Item, typename Dispatch>
+	bool addWaiterLocked(Lane<Item, Dispatch> &lane, uint32_t id, TaskHandle_t task);
+	template <typename Item, typename Dispatch>
+	bool removeWaiterLocked(Lane<Item, Dispatch> &lane, uint32_t id, TaskHandle_t task);
+	template <typename Item, typename Dispatch>
+	bool addCoroutineLocked(Lane<Item, Dispatch> &lane, uint32_t id, ESPTimerResumeNode &node);
+	template <typename Item, typename Dispatch>
+	static ESPTimerResumeNode *takeResumableLocked(Lane<Item, Dispatch> &lane);
+	static void resumeCoroutines(ESPTimerResumeNode *node);
+	friend class ESPTimerAwaiter;
+	bool suspend(ESPTimerAwaiter &awaiter);
+	template <typename Item, typename Dispatch>
+	void recordLateness(Lane<Item, Dispatch> &lane, uint32_t lateMs);
+	template <typename Item, typename Dispatch>
+	static void addLaneLateness(
+	    const Lane<Item, Dispatch> &lane,
+	    uint32_t (&histogram)[kLatenessBuckets],
+	    uint32_t &maxMs
+	);
+	static ESPTimerLateness
+	summarizeLateness(const uint32_t (&histogram)[kLatenessBuckets], uint32_t maxMs);
+	template <typename Item, typename Dispatch>
+	void invokeDispatch(Lane<Item, Dispatch> &lane, Dispatch &dispatch);
+	template <typename Item, typename Dispatch>
+	static void runJob(ESPTimer &timer, void *lane, uint16_t entry);
+	template <typename Item, typename Dispatch> bool stealableBatch(Lane<Item, Dispatch> &lane);
+	bool takeJob(Executor &local, Executor &remote, CallbackJob &job);
+	void wakeExecutor(Executor &executor);
+	template <typename Item, typename Dispatch>
+	void addLaneFootprint(ESPTimerLaneFootprint &footprint, const Lane<Item, Dispatch> &lane) const;
 
-	bool pauseItem(Type type, uint32_t id);
-	bool resumeItem(Type type, uint32_t id);
+	bool control(Type type, ControlOp op, uint32_t id, uint32_t arg = 0);
+	bool postControl(Shard &shard, Type type, const ControlCommand &command, bool &accepted);
+	template <typename Item, typename Dispatch>
+	bool applyControlLocked(
+	    Shard &shard,
+	    Lane<Item, Dispatch> &lane,
+	    const ControlCommand &command
+	);
+	template <typename Item, typename Dispatch>
+	void drainInboxLocked(Shard &shard, Lane<Item, Dispatch> &lane);
+	template <typename Item, typename Dispatch>
 	ESPTimerStatus
-	togglePause(Type type, uint32_t id); // internal: returns new status or Invalid if not found
-	bool clearItem(Type type, uint32_t id);
-	ESPTimerStatus getItemStatus(Type type, uint32_t id);
+	peekStatus(const Lane<Item, Dispatch> &lane, size_t index, uint16_t generation) const;
+	void waitForLockFreeUsers() const;
+};
+
+template <typename Handle> bool ESPTimerAwaiter::await_suspend(Handle handle) noexcept {
+	node_.frame = handle.address();
+	node_.resume = [](void *frame) { Handle::from_address(frame).resume(); };
+	node_.fired = false;
+	return timer_->suspend(*this);
+}
+
+#if defined(ESPTIMER_HAS_COROUTINES)
+// Minimal fire-and-forget coroutine type for timer-driven state machines: it starts running
+// at once and frees its frame when it finishes. The frame is allocated once per coroutine,
+// never per await; if that allocation fails the coroutine simply does not run.
+struct ESPTimerTask {
+	struct promise_type {
+		ESPTimerTask get_return_object() noexcept {
+			return {};
+		}
+		static ESPTimerTask get_return_object_on_allocation_failure() noexcept {
+			return {};
+		}
+		std::suspend_never initial_suspend() noexcept {
+			return {};
+		}
+		std::suspend_never final_suspend() noexcept {
+			return {};
+		}
+		void return_void() noexcept {
+		}
+		void unhandled_exception() noexcept {
+		}
+	};
 };
+#endif
@@ -10,7 +10,15 @@
 #define ESP_TIMER_HAS_BUFFER_MANAGER 0
 #endif
 
+#if __has_include(<esp_heap_caps.h>)
+#include <esp_heap_caps.h>
+#define ESP_TIMER_HAS_HEAP_CAPS 1
+#else
+#define ESP_TIMER_HAS_HEAP_CAPS 0
+#endif
+
 #include <cstddef>
+#include <cstdint>
 #include <cstdlib>
 #include <exception>
 #include <limits>
@@ -18,17 +26,40 @@
 #include <utility>
 #include <vector>
 
+// Heap region a timer-owned buffer is placed in.
+// - Default: regular heap (`malloc` semantics, may land in PSRAM for large blocks).
+// - Internal: on-chip RAM; falls back to the regular heap when internal RAM is exhausted.
+// - PSRAM: external RAM through ESPBufferManager; falls back to the regular heap.
+enum class ESPTimerMemoryRegion : uint8_t { Default = 0, Internal, PSRAM };
+
 namespace timer_allocator_detail {
-inline void *allocate(std::size_t bytes, bool usePSRAMBuffers) noexcept {
+inline void *allocate(std::size_t bytes, ESPTimerMemoryRegion region) noexcept {
+	if (region == ESPTimerMemoryRegion::Internal) {
+#if ESP_TIMER_HAS_HEAP_CAPS
+		void *memory = heap_caps_malloc(bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+		return memory != nullptr ? memory : heap_caps_malloc(bytes, MALLOC_CAP_DEFAULT);
+#else
+		return std::malloc(bytes);
+#endif
+	}
+
 #if ESP_TIMER_HAS_BUFFER_MANAGER
-	return ESPBufferManager::allocate(bytes, usePSRAMBuffers);
+	return ESPBufferManager::allocate(bytes, region == ESPTimerMemoryRegion::PSRAM);
 #else
-	(void)usePSRAMBuffers;
 	return std::malloc(bytes);
 #endif
 }
 
-inline void deallocate(void *ptr) noexcept {
+inline void deallocate(void *ptr, ESPTimerMemoryRegion region) noexcept {
+	if (region == ESPTimerMemoryRegion::Internal) {
+#if ESP_TIMER_HAS_HEAP_CAPS
+		heap_caps_free(ptr);
+#else
+		std::free(ptr);
+#endif
+		return;
+	}
+
 #if ESP_TIMER_HAS_BUFFER_MANAGER
 	ESPBufferManager::deallocate(ptr);
 #else
@@ -42,12 +73,14 @@ template <typename T> class TimerAllocator {
 	using value_type = T;
 
 	TimerAllocator() noexcept = default;
-	explicit TimerAllocator(bool usePSRAMBuffers) noexcept : usePSRAMBuffers_(usePSRAMBuffers) {
+	explicit TimerAllocator(ESPTimerMemoryRegion region) noexcept : region_(region) {
+	}
+	explicit TimerAllocator(bool usePSRAMBuffers) noexcept
+	    : region_(usePSRAMBuffers ? ESPTimerMemoryRegion::PSRAM : ESPTimerMemoryRegion::Default) {
 	}
 
 	template <typename U>
-	TimerAllocator(const TimerAllocator<U> &other) noexcept
-	    : usePSRAMBuffers_(other.usePSRAMBuffers()) {
+	TimerAllocator(const TimerAllocator<U> &other) noexcept : region_(other.region()) {
 	}
 
 	T *allocate(std::size_t n) {
@@ -58,7 +91,7 @@ template <typename T> class TimerAllocator {
 			return nullptr;
 		}
 
-		void *memory = timer_allocator_detail::allocate(n * sizeof(T), usePSRAMBuffers_);
+		void *memory = timer_allocator_detail::allocate(n * sizeof(T), region_);
 		if (memory == nullptr) {
 			return nullptr;
 		}
@@ -66,15 +99,19 @@ template <typename T> class TimerAllocator {
 	}
 
 	void deallocate(T *ptr, std::size_t) noexcept {
-		timer_allocator_detail::deallocate(ptr);
+		timer_allocator_detail::deallocate(ptr, region_);
+	}
+
+	ESPTimerMemoryRegion region() const noexcept {
+		return region_;
 	}
 
 	bool usePSRAMBuffers() const noexcept {
-		return usePSRAMBuffers_;
+		return region_ == ESPTimerMemoryRegion::PSRAM;
 	}
 
 	template <typename U> bool operator==(const TimerAllocator<U> &other) const noexcept {
-		return usePSRAMBuffers_ == other.usePSRAMBuffers();
+		return region_ == other.region();
 	}
 
 	template <typename U> bool operator!=(const TimerAllocator<U> &other) const noexcept {
@@ -84,7 +121,7 @@ template <typename T> class TimerAllocator {
   private:
 	template <typename> friend class TimerAllocator;
 
-	bool usePSRAMBuffers_ = false;
+	ESPTimerMemoryRegion region_ = ESPTimerMemoryRegion::Default;
 };
 
 template <typename T> using TimerVector = std::vector<T, TimerAllocator<T>>;
@@ -95,16 +132,16 @@ inline bool timerTryReserve(TimerVector<T> &buffer, std::size_t requiredCapacity
 		return true;
 	}
 
-	const bool usePSRAMBuffers = buffer.get_allocator().usePSRAMBuffers();
+	const ESPTimerMemoryRegion region = buffer.get_allocator().region();
 	if (requiredCapacity > (std::numeric_limits<std::size_t>::max() / sizeof(T))) {
 		return false;
 	}
 
-	void *probe = timer_allocator_detail::allocate(requiredCapacity * sizeof(T), usePSRAMBuffers);
+	void *probe = timer_allocator_detail::allocate(requiredCapacity * sizeof(T), region);
 	if (probe == nullptr) {
 		return false;
 	}
-	timer_allocator_detail::deallocate(probe);
+	timer_allocator_detail::deallocate(probe, region);
 
 #if defined(__cpp_exceptions)
 	try {
@@ -0,0 +1,157 @@
+#pragma once
+
+#include "timer_allocator.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+
+// Slot storage made of fixed-size chunks that can grow and shrink at the end without moving
+// any element, so references into it (a callback running from its slot, a waiter's node) stay
+// valid while the pool changes size. Chunk `c` holds elements [c << shift, (c + 1) << shift);
+// a fixed pool is a single chunk of exactly its capacity. The chunk table is sized for the
+// largest pool in configure() and never reallocated, and the chunk count is published with
+// release semantics, so lock-free readers that bounds-check against size() only ever see
+// fully constructed chunks. Growing and shrinking are not synchronized otherwise: callers hold
+// the lane lock, and free a detached chunk only once no reader can still be inside it.
+template <typename T> class TimerChunkedVector {
+  public:
+	TimerChunkedVector() = default;
+	explicit TimerChunkedVector(ESPTimerMemoryRegion region) noexcept
+	    : table_(TimerAllocator<T *>(region)) {
+	}
+	TimerChunkedVector(const TimerChunkedVector &) = delete;
+	TimerChunkedVector &operator=(const TimerChunkedVector &) = delete;
+	~TimerChunkedVector() {
+		clear();
+	}
+
+	// `chunkSlots` of 0 makes a fixed pool of `capacity` elements. Otherwise chunks hold
+	// `chunkSlots` rounded up to a power of two, the pool starts with enough of them for
+	// `capacity` and may grow to cover `maxSlots`.
+	bool configure(std::size_t capacity, std::size_t chunkSlots, std::size_t maxSlots) noexcept {
+		clear();
+		std::size_t initialChunks = capacity > 0 ? 1 : 0;
+		std::size_t maxChunks = initialChunks;
+		if (chunkSlots == 0) {
+			shift_ = 0;
+			while ((std::size_t{1} << shift_) < capacity) {
+				++shift_;
+			}
+			length_ = capacity;
+		} else {
+			shift_ = 0;
+			while ((std::size_t{1} << shift_) < chunkSlots) {
+				++shift_;
+			}
+			length_ = std::size_t{1} << shift_;
+			initialChunks = (capacity + length_ - 1) / length_;
+			maxChunks = (std::max(maxSlots, capacity) + length_ - 1) / length_;
+		}
+
+		TimerVector<T *> table(table_.get_allocator());
+		if (!timerTryAssign(table, maxChunks, static_cast<T *>(nullptr))) {
+			return false;
+		}
+		table_.swap(table);
+		for (std::size_t i = 0; i < initialChunks; ++i) {
+			if (!grow()) {
+				clear();
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// Not thread-safe: only swap while no reader can touch either pool.
+	void swap(TimerChunkedVector &other) noexcept {
+		table_.swap(other.table_);
+		std::swap(shift_, other.shift_);
+		std::swap(length_, other.length_);
+		const std::size_t chunks = chunks_.load(std::memory_order_relaxed);
+		chunks_.store(other.chunks_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		other.chunks_.store(chunks, std::memory_order_relaxed);
+	}
+
+	ESPTimerMemoryRegion region() const noexcept {
+		return table_.get_allocator().region();
+	}
+
+	std::size_t size() const noexcept {
+		return chunks_.load(std::memory_order_acquire) * length_;
+	}
+
+	std::size_t chunks() const noexcept {
+		return chunks_.load(std::memory_order_relaxed);
+	}
+
+	std::size_t chunkLength() const noexcept {
+		return length_;
+	}
+
+	std::size_t memoryBytes() const noexcept {
+		return size() * sizeof(T) + table_.capacity() * sizeof(T *);
+	}
+
+	T &operator[](std::size_t index) noexcept {
+		return table_[index >> shift_][index & ((std::size_t{1} << shift_) - 1)];
+	}
+	const T &operator[](std::size_t index) const noexcept {
+		return table_[index >> shift_][index & ((std::size_t{1} << shift_) - 1)];
+	}
+
+	// Appends one value-initialized chunk. Returns false at the limit or when out of memory.
+	bool grow() noexcept {
+		const std::size_t chunks = chunks_.load(std::memory_order_relaxed);
+		if (chunks == table_.size()) {
+			return false;
+		}
+		T *chunk = TimerAllocator<T>(region()).allocate(length_);
+		if (chunk == nullptr) {
+			return false;
+		}
+		for (std::size_t i = 0; i < length_; ++i) {
+			new (&chunk[i]) T();
+		}
+		table_[chunks] = chunk;
+		chunks_.store(chunks + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Unpublishes the last chunk and hands it to the caller, who frees it with release() once
+	// no lock-free reader can still be using it. The table entry is left in place until the
+	// next grow(), because a reader that passed its bounds check may still load it.
+	T *detachLast() noexcept {
+		const std::size_t chunks = chunks_.load(std::memory_order_relaxed);
+		if (chunks == 0) {
+			return nullptr;
+		}
+		chunks_.store(chunks - 1, std::memory_order_release);
+		return table_[chunks - 1];
+	}
+
+	void release(T *chunk) noexcept {
+		if (chunk == nullptr) {
+			return;
+		}
+		for (std::size_t i = 0; i < length_; ++i) {
+			chunk[i].~T();
+		}
+		TimerAllocator<T>(region()).deallocate(chunk, length_);
+	}
+
+  private:
+	void clear() noexcept {
+		while (chunks_.load(std::memory_order_relaxed) > 0) {
+			release(detachLast());
+		}
+	}
+
+	TimerVector<T *> table_;
+	std::size_t shift_ = 0;
+	std::size_t length_ = 0;
+	std::atomic<std::size_t> chunks_{0};
+};
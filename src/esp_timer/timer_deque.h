@@ -0,0 +1,107 @@
+#pragma once
+
+#include "timer_allocator.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+// Fixed-capacity double-ended ring used by the work-stealing executor.
+// The owning core pushes and pops at the back, so it keeps running the jobs it staged most
+// recently; thieves take from the front, where the oldest work waits. Not synchronized:
+// callers hold the executor mutex around every operation. Storage is sized in configure() and
+// only changes through resize(), never while pushing.
+template <typename T> class TimerDeque {
+  public:
+	TimerDeque() = default;
+	explicit TimerDeque(ESPTimerMemoryRegion region) noexcept
+	    : ring_(TimerAllocator<T>(region)) {
+	}
+
+	bool configure(std::size_t capacity) noexcept {
+		TimerVector<T> ring(ring_.get_allocator());
+		if (!timerTryAssign(ring, capacity, T{})) {
+			return false;
+		}
+
+		ring_.swap(ring);
+		head_ = 0;
+		size_ = 0;
+		return true;
+	}
+
+	// Moves the queued values, oldest first, into storage for `capacity` entries. Fails without
+	// changing anything when they do not fit or the allocation fails.
+	bool resize(std::size_t capacity) noexcept {
+		if (capacity < size_) {
+			return false;
+		}
+		TimerVector<T> ring(ring_.get_allocator());
+		if (!timerTryAssign(ring, capacity, T{})) {
+			return false;
+		}
+		for (std::size_t i = 0; i < size_; ++i) {
+			ring[i] = ring_[(head_ + i) % ring_.size()];
+		}
+
+		ring_.swap(ring);
+		head_ = 0;
+		return true;
+	}
+
+	void swap(TimerDeque &other) noexcept {
+		ring_.swap(other.ring_);
+		std::swap(head_, other.head_);
+		std::swap(size_, other.size_);
+	}
+
+	ESPTimerMemoryRegion region() const noexcept {
+		return ring_.get_allocator().region();
+	}
+
+	std::size_t capacity() const noexcept {
+		return ring_.size();
+	}
+
+	std::size_t memoryBytes() const noexcept {
+		return ring_.capacity() * sizeof(T);
+	}
+
+	bool empty() const noexcept {
+		return size_ == 0;
+	}
+
+	// Returns false when the ring is full or unconfigured.
+	bool pushBack(const T &value) noexcept {
+		if (size_ == ring_.size()) {
+			return false;
+		}
+		ring_[(head_ + size_) % ring_.size()] = value;
+		++size_;
+		return true;
+	}
+
+	bool popBack(T &value) noexcept {
+		if (size_ == 0) {
+			return false;
+		}
+		--size_;
+		value = ring_[(head_ + size_) % ring_.size()];
+		return true;
+	}
+
+	bool popFront(T &value) noexcept {
+		if (size_ == 0) {
+			return false;
+		}
+		value = ring_[head_];
+		head_ = (head_ + 1) % ring_.size();
+		--size_;
+		return true;
+	}
+
+  private:
+	TimerVector<T> ring_;
+	std::size_t head_ = 0;
+	std::size_t size_ = 0;
+};
@@ -0,0 +1,128 @@
+#pragma once
+
+#include "timer_allocator.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Bounded lock-free multi-producer, single-consumer queue.
+// Producers claim a cell with one compare-and-swap on `head_` and publish it through the
+// cell's sequence number; the single consumer never writes `head_`, so producers on one core
+// and the consumer on another only share the cells they hand over. Storage is sized once in
+// configure() and never grows.
+template <typename T> class TimerInbox {
+  public:
+	TimerInbox() = default;
+	explicit TimerInbox(ESPTimerMemoryRegion region) noexcept
+	    : cells_(TimerAllocator<Cell>(region)) {
+	}
+
+	// Rounds `capacity` up to a power of two. A capacity of 0 leaves the inbox unusable.
+	bool configure(std::size_t capacity) noexcept {
+		TimerVector<Cell> cells(cells_.get_allocator());
+		std::size_t size = 0;
+		if (capacity > 0) {
+			size = 1;
+			while (size < capacity) {
+				size <<= 1;
+			}
+			if (!timerTryAssign(cells, size, Cell{})) {
+				return false;
+			}
+			for (std::size_t i = 0; i < size; ++i) {
+				cells[i].sequence.store(static_cast<uint32_t>(i), std::memory_order_relaxed);
+			}
+		}
+
+		cells_.swap(cells);
+		mask_ = size > 0 ? static_cast<uint32_t>(size - 1) : 0;
+		head_.store(0, std::memory_order_relaxed);
+		tail_ = 0;
+		return true;
+	}
+
+	// Not thread-safe: only swap while no producer or consumer can touch either inbox.
+	void swap(TimerInbox &other) noexcept {
+		cells_.swap(other.cells_);
+		const uint32_t mask = mask_;
+		mask_ = other.mask_;
+		other.mask_ = mask;
+		const uint32_t head = head_.load(std::memory_order_relaxed);
+		head_.store(other.head_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		other.head_.store(head, std::memory_order_relaxed);
+		const uint32_t tail = tail_;
+		tail_ = other.tail_;
+		other.tail_ = tail;
+	}
+
+	ESPTimerMemoryRegion region() const noexcept {
+		return cells_.get_allocator().region();
+	}
+
+	std::size_t memoryBytes() const noexcept {
+		return cells_.capacity() * sizeof(Cell);
+	}
+
+	// Any task. Returns false when the inbox is full or unconfigured.
+	bool push(const T &value) noexcept {
+		if (cells_.empty()) {
+			return false;
+		}
+		uint32_t pos = head_.load(std::memory_order_relaxed);
+		for (;;) {
+			Cell &cell = cells_[pos & mask_];
+			const uint32_t sequence = cell.sequence.load(std::memory_order_acquire);
+			const int32_t diff = static_cast<int32_t>(sequence - pos);
+			if (diff == 0) {
+				if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+					cell.value = value;
+					cell.sequence.store(pos + 1, std::memory_order_release);
+					return true;
+				}
+			} else if (diff < 0) {
+				return false;
+			} else {
+				pos = head_.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	// Consumer task only.
+	bool pop(T &value) noexcept {
+		if (cells_.empty()) {
+			return false;
+		}
+		Cell &cell = cells_[tail_ & mask_];
+		const uint32_t sequence = cell.sequence.load(std::memory_order_acquire);
+		if (static_cast<int32_t>(sequence - (tail_ + 1)) < 0) {
+			return false;
+		}
+		value = cell.value;
+		cell.sequence.store(tail_ + mask_ + 1, std::memory_order_release);
+		++tail_;
+		return true;
+	}
+
+  private:
+	struct Cell {
+		std::atomic<uint32_t> sequence{0};
+		T value{};
+
+		Cell() = default;
+		Cell(const Cell &other)
+		    : sequence(other.sequence.load(std::memory_order_relaxed)), value(other.value) {
+		}
+		Cell &operator=(const Cell &other) {
+			const uint32_t otherSequence = other.sequence.load(std::memory_order_relaxed);
+			sequence.store(otherSequence, std::memory_order_relaxed);
+			value = other.value;
+			return *this;
+		}
+	};
+
+	TimerVector<Cell> cells_;
+	uint32_t mask_ = 0;
+	std::atomic<uint32_t> head_{0};
+	uint32_t tail_ = 0;
+};
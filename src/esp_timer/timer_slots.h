@@ -0,0 +1,181 @@
+#pragma once
+
+#include "timer_allocator.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+// Occupancy bitmap for a fixed pool of timer slots.
+// One bit per slot plus a summary bit per word that is set while the word is full, so
+// acquiring a free slot is two count-trailing-zeros lookups per 1024 slots and releasing
+// one is a constant-time bit clear. Iteration skips empty words entirely.
+class TimerSlotBitmap {
+  public:
+	TimerSlotBitmap() = default;
+	explicit TimerSlotBitmap(ESPTimerMemoryRegion region) noexcept
+	    : used_(TimerAllocator<uint32_t>(region)), full_(TimerAllocator<uint32_t>(region)) {
+	}
+
+	bool configure(std::size_t capacity) noexcept {
+		const std::size_t words = (capacity + kBits - 1) / kBits;
+		TimerVector<uint32_t> used(used_.get_allocator());
+		TimerVector<uint32_t> full(full_.get_allocator());
+		if (!timerTryAssign(used, words, 0u)) {
+			return false;
+		}
+		if (!timerTryAssign(full, (words + kBits - 1) / kBits, 0u)) {
+			return false;
+		}
+
+		used_.swap(used);
+		full_.swap(full);
+		capacity_ = capacity;
+		count_ = 0;
+		return true;
+	}
+
+	void swap(TimerSlotBitmap &other) noexcept {
+		used_.swap(other.used_);
+		full_.swap(other.full_);
+		std::swap(capacity_, other.capacity_);
+		std::swap(count_, other.count_);
+	}
+
+	ESPTimerMemoryRegion region() const noexcept {
+		return used_.get_allocator().region();
+	}
+
+	std::size_t capacity() const noexcept {
+		return capacity_;
+	}
+
+	std::size_t size() const noexcept {
+		return count_;
+	}
+
+	std::size_t memoryBytes() const noexcept {
+		return (used_.capacity() + full_.capacity()) * sizeof(uint32_t);
+	}
+
+	bool contains(std::size_t index) const noexcept {
+		return index < capacity_ && (used_[index / kBits] & bit(index)) != 0;
+	}
+
+	// Claims the lowest free slot. Returns false when every slot is in use.
+	bool acquire(std::size_t &index) noexcept {
+		for (std::size_t summary = 0; summary < full_.size(); ++summary) {
+			const uint32_t open = ~full_[summary] & summaryMask(summary);
+			if (open == 0) {
+				continue;
+			}
+
+			const std::size_t word = summary * kBits + ctz(open);
+			const uint32_t freeBits = ~used_[word] & wordMask(word);
+			index = word * kBits + ctz(freeBits);
+			used_[word] |= bit(index);
+			if (used_[word] == wordMask(word)) {
+				full_[summary] |= bit(word);
+			}
+			++count_;
+			return true;
+		}
+		return false;
+	}
+
+	// Claims a specific slot. Returns false when it is out of range or already in use.
+	bool claim(std::size_t index) noexcept {
+		if (index >= capacity_ || contains(index)) {
+			return false;
+		}
+		const std::size_t word = index / kBits;
+		used_[word] |= bit(index);
+		if (used_[word] == wordMask(word)) {
+			full_[word / kBits] |= bit(word);
+		}
+		++count_;
+		return true;
+	}
+
+	void release(std::size_t index) noexcept {
+		if (!contains(index)) {
+			return;
+		}
+		const std::size_t word = index / kBits;
+		used_[word] &= ~bit(index);
+		full_[word / kBits] &= ~bit(word);
+		--count_;
+	}
+
+	// True when any slot in [begin, end) is occupied.
+	bool anyInRange(std::size_t begin, std::size_t end) const noexcept {
+		if (end > capacity_) {
+			end = capacity_;
+		}
+		while (begin < end) {
+			const std::size_t word = begin / kBits;
+			const std::size_t wordEnd = end < (word + 1) * kBits ? end : (word + 1) * kBits;
+			const uint32_t mask = lowMask(wordEnd - word * kBits) & ~lowMask(begin - word * kBits);
+			if ((used_[word] & mask) != 0) {
+				return true;
+			}
+			begin = wordEnd;
+		}
+		return false;
+	}
+
+	// Returns the lowest occupied slot matching `pred`, or capacity() when none does.
+	template <typename Pred> std::size_t findIf(Pred &&pred) const {
+		for (std::size_t word = 0; word < used_.size(); ++word) {
+			uint32_t bits = used_[word];
+			while (bits != 0) {
+				const std::size_t index = word * kBits + ctz(bits);
+				bits &= bits - 1;
+				if (pred(index)) {
+					return index;
+				}
+			}
+		}
+		return capacity_;
+	}
+
+	// Visits every occupied slot in ascending index order.
+	template <typename Fn> void forEach(Fn &&fn) const {
+		for (std::size_t word = 0; word < used_.size(); ++word) {
+			uint32_t bits = used_[word];
+			while (bits != 0) {
+				const std::size_t index = word * kBits + ctz(bits);
+				bits &= bits - 1;
+				fn(index);
+			}
+		}
+	}
+
+  private:
+	static constexpr std::size_t kBits = 32;
+
+	static uint32_t bit(std::size_t index) noexcept {
+		return 1u << (index % kBits);
+	}
+
+	static std::size_t ctz(uint32_t value) noexcept {
+		return static_cast<std::size_t>(__builtin_ctz(value));
+	}
+
+	static uint32_t lowMask(std::size_t count) noexcept {
+		return count >= kBits ? ~0u : ((1u << count) - 1u);
+	}
+
+	uint32_t wordMask(std::size_t word) const noexcept {
+		return lowMask(capacity_ - word * kBits);
+	}
+
+	uint32_t summaryMask(std::size_t summary) const noexcept {
+		return lowMask(used_.size() - summary * kBits);
+	}
+
+	TimerVector<uint32_t> used_;
+	TimerVector<uint32_t> full_;
+	std::size_t capacity_ = 0;
+	std::size_t count_ = 0;
+};
@@ -1,11 +1,29 @@
 #include <Arduino.h>
 #include <ESPTimer.h>
+#include <atomic>
 #include <unity.h>
 
+namespace {
+// Polls `done` every millisecond for up to `timeoutMs`. Tests wait for an outcome with a
+// generous bound instead of asserting after a fixed delay, so a loaded board only runs slower.
+template <typename Fn> bool waitUntil(Fn &&done, uint32_t timeoutMs = 2000) {
+	const uint32_t start = millis();
+	while (!done()) {
+		if (millis() - start >= timeoutMs) {
+			return false;
+		}
+		delay(1);
+	}
+	return true;
+}
+} // namespace
+
 void test_api_compiles() {
 	ESPTimer timer;
 	ESPTimerConfig cfg;
 	cfg.usePSRAMBuffers = true;
+	cfg.slotMemory = ESPTimerMemoryRegion::Internal;
+	cfg.callbackMemory = ESPTimerMemoryRegion::PSRAM;
 	cfg.maxTimeouts = 4;
 	cfg.maxIntervals = 4;
 	cfg.maxSecCounters = 2;
@@ -113,6 +131,1242 @@ void test_capacity_limits_return_zero_without_corrupting_existing_timers() {
 	TEST_ASSERT_FALSE(timer.isInitialized());
 }
 
+void test_released_slots_are_reused_immediately() {
+	ESPTimer timer;
+	ESPTimerConfig cfg;
+	cfg.maxTimeouts = 2;
+	timer.init(cfg);
+	TEST_ASSERT_TRUE(timer.isInitialized());
+
+	volatile bool fired = false;
+	auto firstId = timer.setTimeout([&fired]() { fired = true; }, 5);
+	auto secondId = timer.setTimeout([]() {}, 60000);
+	TEST_ASSERT_TRUE(firstId > 0);
+	TEST_ASSERT_TRUE(secondId > 0);
+	TEST_ASSERT_EQUAL_UINT32(0, timer.setTimeout([]() {}, 60000));
+
+	// A cleared slot is returned to the pool right away.
+	TEST_ASSERT_TRUE(timer.clearTimeout(secondId));
+	auto thirdId = timer.setTimeout([]() {}, 60000);
+	TEST_ASSERT_TRUE(thirdId > 0);
+
+	// A completed timeout frees its slot as soon as its callback returns.
+	delay(50);
+	TEST_ASSERT_TRUE(fired);
+	TEST_ASSERT_EQUAL_UINT8(
+	    static_cast<uint8_t>(ESPTimerStatus::Invalid),
+	    static_cast<uint8_t>(timer.getStatus(firstId))
+	);
+	TEST_ASSERT_TRUE(timer.setTimeout([]() {}, 60000) > 0);
+
+	timer.deinit();
+}
+
+void test_stale_ids_and_memory_footprint() {
+	ESPTimer timer;
+	TEST_ASSERT_EQUAL_UINT32(0, timer.memoryFootprint().totalBytes());
+
+	ESPTimerConfig cfg;
+	cfg.maxTimeouts = 1;
+	timer.init(cfg);
+	TEST_ASSERT_TRUE(timer.isInitialized());
+
+	auto firstId = timer.setTimeout([]() {}, 60000);
+	TEST_ASSERT_TRUE(firstId > 0);
+	TEST_ASSERT_FALSE(timer.clearInterval(firstId));
+	TEST_ASSERT_TRUE(timer.clearTimeout(firstId));
+
+	// The slot is reused under a new generation; the old ID must not reach it.
+	auto secondId = timer.setTimeout([]() {}, 60000);
+	TEST_ASSERT_TRUE(secondId > 0);
+	TEST_ASSERT_TRUE(secondId != firstId);
+	TEST_ASSERT_FALSE(timer.clearTimeout(firstId));
+	TEST_ASSERT_EQUAL_UINT8(
+	    static_cast<uint8_t>(ESPTimerStatus::Invalid),
+	    static_cast<uint8_t>(timer.getStatus(firstId))
+	);
+	TEST_ASSERT_EQUAL_UINT8(
+	    static_cast<uint8_t>(ESPTimerStatus::Running),
+	    static_cast<uint8_t>(timer.getStatus(secondId))
+	);
+
+	const ESPTimerMemoryFootprint footprint = timer.memoryFootprint();
+	TEST_ASSERT_EQUAL_UINT32(1, footprint.timeouts.slots);
+	TEST_ASSERT_EQUAL_UINT32(cfg.maxIntervals, footprint.intervals.slots);
+	TEST_ASSERT_TRUE(footprint.timeouts.slotBytes > 0);
+	TEST_ASSERT_TRUE(footprint.timeouts.callbackBytes > 0);
+	TEST_ASSERT_TRUE(footprint.totalBytes() > footprint.timeouts.totalBytes());
+
+	timer.deinit();
+	TEST_ASSERT_EQUAL_UINT32(0, timer.memoryFootprint().totalBytes());
+}
+
+void test_status_queries_follow_pause_and_clear() {
+	ESPTimer timer;
+	TEST_ASSERT_FALSE(timer.isRunning(1));
+
+	timer.init();
+	TEST_ASSERT_TRUE(timer.isInitialized());
+
+	auto intervalId = timer.setInterval([]() {}, 1000);
+	TEST_ASSERT_TRUE(intervalId > 0);
+	TEST_ASSERT_TRUE(timer.isRunning(intervalId));
+
+	TEST_ASSERT_TRUE(timer.pauseInterval(intervalId));
+	TEST_ASSERT_FALSE(timer.isRunning(intervalId));
+	TEST_ASSERT_EQUAL_UINT8(
+	    static_cast<uint8_t>(ESPTimerStatus::Paused),
+	    static_cast<uint8_t>(timer.getStatus(intervalId))
+	);
+
+	TEST_ASSERT_TRUE(timer.clearInterval(intervalId));
+	TEST_ASSERT_FALSE(timer.isRunning(intervalId));
+	TEST_ASSERT_EQUAL_UINT8(
+	    static_cast<uint8_t>(ESPTimerStatus::Invalid),
+	    static_cast<uint8_t>(timer.getStatus(intervalId))
+	);
+
+	timer.deinit();
+	TEST_ASSERT_FALSE(timer.isRunning(intervalId));
+}
+
+void test_batched_dispatch_completes_every_timer() {
+	ESPTimer timer;
+	ESPTimerConfig cfg;
+	cfg.maxTimeouts = 8;
+	timer.init(cfg);
+	TEST_ASSERT_TRUE(timer.isInitialized());
+
+	static volatile uint32_t fired = 0;
+	static volatile uint32_t intervalRuns = 0;
+	static uint32_t intervalId = 0;
+	fired = 0;
+	intervalRuns = 0;
+
+	for (int i = 0; i < 8; ++i) {
+		TEST_ASSERT_TRUE(timer.setTimeout([]() { fired = fired + 1; }, 5) > 0);
+	}
+	// An interval that clears itself from its own callback must fire exactly once.
+	intervalId = timer.setInterval(
+	    [&timer]() {
+		    intervalRuns = intervalRuns + 1;
+		    timer.clearInterval(intervalId);
+	    },
+	    5
+	);
+	TEST_ASSERT_TRUE(intervalId > 0);
+
+	delay(100);
+	TEST_ASSERT_EQUAL_UINT32(8, fired);
+	TEST_ASSERT_EQUAL_UINT32(1, intervalRuns);
+	TEST_ASSERT_FALSE(timer.isRunning(intervalId));
+	for (int i = 0; i < 8; ++i) {
+		TEST_ASSERT_TRUE(timer.setTimeout([]() {}, 60000) > 0);
+	}
+
+	timer.deinit();
+}
+
+void test_restart_and_reschedule_keep_ids() {
+	ESPTimer timer;
+	ESPTimerConfig cfg;
+	cfg.maxTimeouts = 2;
+	timer.init(cfg);
+	TEST_ASSERT_TRUE(timer.isInitialized());
+
+	static volatile uint32_t watchdogFired = 0;
+	static volatile uint32_t selfRearms = 0;
+	static uint32_t selfId = 0;
+	watchdogFired = 0;
+	selfRearms = 0;
+
+	// Restarts every 20 ms keep a 200 ms watchdog from firing, with ample room for preemption.
+	const uint32_t watchdogId = timer.setTimeout([]() { watchdogFired = watchdogFired + 1; }, 200);
+	TEST_ASSERT_TRUE(watchdogId > 0);
+	for (int i = 0; i < 5; ++i) {
+		delay(20);
+		TEST_ASSERT_TRUE(timer.restartTimeout(watchdogId));
+	}
+	TEST_ASSERT_EQUAL_UINT32(0, watchdogFired);
+	TEST_ASSERT_TRUE(timer.isRunning(watchdogId));
+
+	TEST_ASSERT_TRUE(timer.rescheduleTimeout(watchdogId, 5));
+	TEST_ASSERT_TRUE(waitUntil([&]() { return !timer.isRunning(watchdogId); }));
+	TEST_ASSERT_EQUAL_UINT32(1, watchdogFired);
+	TEST_ASSERT_FALSE(timer.restartTimeout(watchdogId));
+
+	// Re-arming from inside the callback keeps the timeout alive under the same ID.
+	selfId = timer.setTimeout(
+	    [&timer]() {
+		    selfRearms = selfRearms + 1;
+		    if (selfRearms < 3) {
+			    timer.restartTimeout(selfId);
+		    }
+	    },
+	    5
+	);
+	TEST_ASSERT_TRUE(selfId > 0);
+	TEST_ASSERT_TRUE(waitUntil([&]() { return selfRearms == 3 && !timer.isRunning(selfId); }));
+	TEST_ASSERT_EQUAL_UINT32(3, selfRearms);
+	TEST_ASSERT_FALSE(timer.isRunning(selfId));
+
+	const uint32_t intervalId = timer.setInterval([]() {}, 1000);
+	TEST_ASSERT_TRUE(timer.setIntervalPeriod(intervalId, 10));
+	TEST_ASSERT_FALSE(timer.setIntervalPeriod(watchdogId, 10));
+	TEST_ASSERT_FALSE(timer.rescheduleTimeout(intervalId, 10));
+	TEST_ASSERT_TRUE(timer.isRunning(intervalId));
+
+	timer.deinit();
+	TEST_ASSERT_FALSE(timer.restartTimeout(selfId));
+}
+
+void test_debounce_and_throttle_reuse_their_slot() {
+	ESPTimer timer;
+	ESPTimerConfig cfg;
+	cfg.maxTimeouts = 2;
+	timer.init(cfg);
+	TEST_ASSERT_TRUE(timer.isInitialized());
+
+	static volatile uint32_t debounced = 0;
+	static volatile uint32_t throttled = 0;
+	debounced = 0;
+	throttled = 0;
+
+	const uint32_t debounceId = timer.setDebounce([]() { debounced = debounced + 1; }, 30);
+	const uint32_t throttleId = timer.setThrottle([]() { throttled = throttled + 1; }, 50);
+	TEST_ASSERT_TRUE(debounceId > 0);
+	TEST_ASSERT_TRUE(throttleId > 0);
+	TEST_ASSERT_EQUAL_UINT8(
+	    static_cast<uint8_t>(ESPTimerStatus::Completed),
+	    static_cast<uint8_t>(timer.getStatus(debounceId))
+	);
+
+	// A burst of triggers on a full lane: one debounced call after the burst, one leading and
+	// one trailing throttled call.
+	TEST_ASSERT_EQUAL_UINT32(0, timer.setTimeout([]() {}, 10));
+	for (int i = 0; i < 8; ++i) {
+		TEST_ASSERT_TRUE(timer.debounce(debounceId));
+		TEST_ASSERT_TRUE(timer.throttle(throttleId));
+		delay(5);
+	}
+	TEST_ASSERT_EQUAL_UINT32(0, debounced);
+	delay(100);
+	TEST_ASSERT_EQUAL_UINT32(1, debounced);
+	TEST_ASSERT_EQUAL_UINT32(2, throttled);
+
+	// Handles stay valid after firing and can be triggered again.
+	TEST_ASSERT_TRUE(timer.debounce(debounceId));
+	TEST_ASSERT_TRUE(timer.isRunning(debounceId));
+	delay(60);
+	TEST_ASSERT_EQUAL_UINT32(2, debounced);
+
+	TEST_ASSERT_TRUE(timer.clearTimeout(throttleId));
+	TEST_ASSERT_FALSE(timer.throttle(throttleId));
+	const uint32_t plainId = timer.setTimeout([]() {}, 1000);
+	TEST_ASSERT_TRUE(plainId > 0);
+	TEST_ASSERT_FALSE(timer.debounce(plainId));
+
+	timer.deinit();
+}
+
+void test_counter_lane_ticks_per_timer() {
+	ESPTimer timer;
+	TEST_ASSERT_EQUAL_UINT32(0, timer.setCounter([](uint32_t) {}, 1000, 100));
+	ESPTimerConfig cfg;
+	cfg.maxCounters = 2;
+	timer.init(cfg);
+	TEST_ASSERT_TRUE(timer.isInitialized());
+	TEST_ASSERT_EQUAL_UINT32(0, timer.setCounter([](uint32_t) {}, 1000, 0));
+
+	static volatile uint32_t fastTicks = 0;
+	static volatile uint32_t slowTicks = 0;
+	static volatile uint32_t lastFastLeft = UINT32_MAX;
+	static volatile int lastSecLeft = -1;
+	fastTicks = 0;
+	slowTicks = 0;
+	lastFastLeft = UINT32_MAX;
+	lastSecLeft = -1;
+
+	const uint32_t fastId = timer.setCounter(
+	    [](uint32_t ticksLeft) {
+		    fastTicks = fastTicks + 1;
+		    lastFastLeft = ticksLeft;
+	    },
+	    200,
+	    50
+	);
+	const uint32_t secId = timer.setSecCounter(
+	    [](int secLeft) {
+		    slowTicks = slowTicks + 1;
+		    lastSecLeft = secLeft;
+	    },
+	    60000
+	);
+	TEST_ASSERT_TRUE(fastId > 0);
+	TEST_ASSERT_TRUE(secId > 0);
+	TEST_ASSERT_EQUAL_UINT32(0, timer.setCounter([](uint32_t) {}, 1000, 100));
+	TEST_ASSERT_EQUAL_UINT32(2, timer.memoryFootprint().counters.slots);
+
+	delay(400);
+	TEST_ASSERT_EQUAL_UINT32(4, fastTicks);
+	TEST_ASSERT_EQUAL_UINT32(0, lastFastLeft);
+	TEST_ASSERT_FALSE(timer.isRunning(fastId));
+	TEST_ASSERT_EQUAL_UINT32(0, slowTicks);
+	TEST_ASSERT_TRUE(timer.isRunning(secId));
+
+	delay(700);
+	TEST_ASSERT_EQUAL_UINT32(1, slowTicks);
+	TEST_ASSERT_EQUAL_INT(59, lastSecLeft);
+	TEST_ASSERT_TRUE(timer.pauseCounter(secId));
+	TEST_ASSERT_TRUE(timer.resumeSecCounter(secId));
+	TEST_ASSERT_TRUE(timer.clearCounter(secId));
+
+	timer.deinit();
+}
+
+void test_counter_ticks_align_to_deadline_boundaries() {
+	ESPTimer timer;
+	ESPTimerConfig cfg;
+	cfg.maxCounters = 1;
+	timer.init(cfg);
+	TEST_ASSERT_TRUE(timer.isInitialized());
+
+	static volatile uint32_t calls = 0;
+	static uint32_t values[4] = {};
+	static uint32_t offsetsMs[4] = {};
+	static uint32_t startMs = 0;
+	calls = 0;
+
+	// 250 ms in 100 ms ticks: the value changes at 50, 150 and 250 ms, not at 100/200/300.
+	startMs = millis();
+	const uint32_t id = timer.setCounter(
+	    [](uint32_t ticksLeft) {
+		    if (calls < 4) {
+			    values[calls] = ticksLeft;
+			    offsetsMs[calls] = millis() - startMs;
+		    }
+		    calls = calls + 1;
+	    },
+	    250,
+	    100
+	);
+	TEST_ASSERT_TRUE(id > 0);
+
+	delay(400);
+	TEST_ASSERT_EQUAL_UINT32(3, calls);
+	TEST_ASSERT_EQUAL_UINT32(2, values[0]);
+	TEST_ASSERT_EQUAL_UINT32(1, values[1]);
+	TEST_ASSERT_EQUAL_UINT32(0, values[2]);
+	TEST_ASSERT_UINT32_WITHIN(15, 50, offsetsMs[0]);
+	TEST_ASSERT_UINT32_WITHIN(15, 150, offsetsMs[1]);
+	TEST_ASSERT_UINT32_WITHIN(15, 250, offsetsMs[2]);
+
+	timer.deinit();
+}
+
+void test_rate_limited_and_adaptive_ms_counters() {
+	ESPTimer timer;
+	ESPTimerConfig cfg;
+	cfg.maxCounters = 2;
+	timer.init(cfg);
+	TEST_ASSERT_TRUE(timer.isInitialized());
+
+	static volatile uint32_t limitedCalls = 0;
+	static volatile uint32_t limitedLeft = UINT32_MAX;
+	static volatile uint32_t adaptiveCalls = 0;
+	static volatile uint32_t slowCalls = 0;
+	static volatile uint32_t adaptiveLeft = UINT32_MAX;
+	limitedCalls = 0;
+	limitedLeft = UINT32_MAX;
+	adaptiveCalls = 0;
+	slowCalls = 0;
+	adaptiveLeft = UINT32_MAX;
+
+	const uint32_t limitedId = timer.setMsCounter(
+	    [](uint32_t msLeft) {
+		    limitedCalls = limitedCalls + 1;
+		    limitedLeft = msLeft;
+	    },
+	    200,
+	    50
+	);
+	// Slow (50 ms) while more than 100 ms remain, then every millisecond.
+	const uint32_t adaptiveId = timer.setAdaptiveMsCounter(
+	    [](uint32_t msLeft) -> uint32_t {
+		    adaptiveCalls = adaptiveCalls + 1;
+		    adaptiveLeft = msLeft;
+		    if (msLeft > 100) {
+			    slowCalls = slowCalls + 1;
+		    }
+		    return msLeft > 100 ? 50 : 1;
+	    },
+	    300
+	);
+	TEST_ASSERT_TRUE(limitedId > 0);
+	TEST_ASSERT_TRUE(adaptiveId > 0);
+
+	TEST_ASSERT_TRUE(waitUntil([&]() {
+		return !timer.isRunning(limitedId) && !timer.isRunning(adaptiveId);
+	}));
+
+	// A late worker can only merge ticks, so the caps are upper bounds and both counters still
+	// end with 0 left.
+	TEST_ASSERT_TRUE(limitedCalls >= 1 && limitedCalls <= 4);
+	TEST_ASSERT_EQUAL_UINT32(0, limitedLeft);
+	TEST_ASSERT_TRUE(slowCalls >= 1 && slowCalls <= 5);
+	TEST_ASSERT_TRUE(adaptiveCalls >= slowCalls + 10);
+	TEST_ASSERT_EQUAL_UINT32(0, adaptiveLeft);
+
+	timer.deinit();
+}
+
+void test_event_timers_post_to_queues_and_notifications() {
+	ESPTimer timer;
+	ESPTimerConfig cfg;
+	cfg.maxTimeouts = 2;
+	cfg.maxIntervals = 1;
+	cfg.maxCounters = 1;
+	timer.init(cfg);
+	TEST_ASSERT_TRUE(timer.isInitialized());
+
+	QueueHandle_t queue = xQueueCreate(8, sizeof(ESPTimerEvent));
+	TEST_ASSERT_NOT_NULL(queue);
+	const ESPTimerEventSink toQueue = ESPTimerEventSink::queue(queue);
+
+	const uint32_t timeoutId = timer.setTimeoutEvent(toQueue, 7, 20);
+	TEST_ASSERT_TRUE(timeoutId > 0);
+	ESPTimerEvent event;
+	TEST_ASSERT_TRUE(xQueueReceive(queue, &event, pdMS_TO_TICKS(200)) == pdTRUE);
+	TEST_ASSERT_EQUAL_UINT32(timeoutId, event.id);
+	TEST_ASSERT_EQUAL_UINT32(7, event.tag);
+	TEST_ASSERT_EQUAL_UINT32(0, event.value);
+	TEST_ASSERT_EQUAL_UINT8(
+	    static_cast<uint8_t>(ESPTimerStatus::Invalid),
+	    static_cast<uint8_t>(timer.getStatus(timeoutId))
+	);
+
+	// Counter events carry the ticks left, ending with 0 on the deadline.
+	const uint32_t counterId = timer.setCounterEvent(toQueue, 9, 100, 50);
+	TEST_ASSERT_TRUE(counterId > 0);
+	for (uint32_t expected : {1u, 0u}) {
+		TEST_ASSERT_TRUE(xQueueReceive(queue, &event, pdMS_TO_TICKS(200)) == pdTRUE);
+		TEST_ASSERT_EQUAL_UINT32(counterId, event.id);
+		TEST_ASSERT_EQUAL_UINT32(9, event.tag);
+		TEST_ASSERT_EQUAL_UINT32(expected, event.value);
+	}
+
+	// Interval events can just set a notification bit on the waiting task.
+	xTaskNotifyStateClearIndexed(nullptr, 0);
+	ulTaskNotifyValueClearIndexed(nullptr, 0, 0xFFFFFFFFu);
+	const ESPTimerEventSink toTask = ESPTimerEventSink::notify(xTaskGetCurrentTaskHandle(), 0x4);
+	const uint32_t intervalId = timer.setIntervalEvent(toTask, 0, 10);
+	TEST_ASSERT_TRUE(intervalId > 0);
+	uint32_t bits = 0;
+	TEST_ASSERT_TRUE(xTaskNotifyWait(0, 0xFFFFFFFFu, &bits, pdMS_TO_TICKS(200)) == pdTRUE);
+	TEST_ASSERT_EQUAL_UINT32(0x4, bits);
+	TEST_ASSERT_TRUE(timer.clearInterval(intervalId));
+
+	// A full queue drops events instead of blocking the worker.
+	for (int i = 0; i < 8; ++i) {
+		xQueueSend(queue, &event, 0);
+	}
+	TEST_ASSERT_TRUE(timer.setTimeoutEvent(toQueue, 1, 1) > 0);
+	delay(30);
+	TEST_ASSERT_EQUAL_UINT32(1, timer.droppedEvents());
+
+	timer.deinit();
+	vQueueDelete(queue);
+}
+
+void test_priority_classes_order_each_batch() {
+	ESPTimer timer;
+	ESPTimerConfig cfg;
+	cfg.maxTimeouts = 5;
+	timer.init(cfg);
+	TEST_ASSERT_TRUE(timer.isInitialized());
+
+	static char order[8];
+	static std::atomic<uint8_t> fired{0};
+	static std::atomic<bool> gateEntered{false};
+	static std::atomic<bool> gateOpen{false};
+	memset(order, 0, sizeof(order));
+	fired = 0;
+	gateEntered = false;
+	gateOpen = false;
+
+	// Hold the worker in a callback until the next four timers have all come due, so they run
+	// in one pass however late the board schedules anything.
+	TEST_ASSERT_TRUE(timer.setTimeout(
+	    []() {
+		    gateEntered = true;
+		    while (!gateOpen) {
+			    delay(1);
+		    }
+	    },
+	    1
+	) > 0);
+	TEST_ASSERT_TRUE(waitUntil([]() { return gateEntered.load(); }));
+	const uint32_t lateLow = timer.setTimeout([]() { order[fired++] = 'l'; }, 3);
+	const uint32_t earlyLow = timer.setTimeout([]() { order[fired++] = 'e'; }, 1);
+	const uint32_t normal = timer.setTimeout([]() { order[fired++] = 'n'; }, 2);
+	const uint32_t high = timer.setTimeout([]() { order[fired++] = 'H'; }, 4);
+	TEST_ASSERT_TRUE(timer.setPriority(lateLow, ESPTimerPriority::Low));
+	TEST_ASSERT_TRUE(timer.setPriority(earlyLow, ESPTimerPriority::Low));
+	TEST_ASSERT_TRUE(timer.setPriority(high, ESPTimerPriority::High));
+	TEST_ASSERT_TRUE(normal > 0);
+	delay(10);
+	gateOpen = true;
+
+	TEST_ASSERT_TRUE(waitUntil([]() { return fired == 4; }));
+	TEST_ASSERT_EQUAL_STRING("Hnel", order);
+	TEST_ASSERT_TRUE(waitUntil([&]() { return timer.getStatus(high) == ESPTimerStatus::Invalid; }));
+	TEST_ASSERT_FALSE(timer.setPriority(high, ESPTimerPriority::Low)); // completed and freed
+
+	timer.deinit();
+}
+
+void test_lateness_stats_and_slot_order_dispatch() {
+	ESPTimer timer;
+	ESPTimerConfig cfg;
+	cfg.maxTimeouts = 5;
+	cfg.orderDispatch = false;
+	timer.init(cfg);
+	TEST_ASSERT_TRUE(timer.isInitialized());
+
+	static char order[8];
+	static std::atomic<uint8_t> fired{0};
+	static std::atomic<bool> gateEntered{false};
+	static std::atomic<bool> gateOpen{false};
+	memset(order, 0, sizeof(order));
+	fired = 0;
+	gateEntered = false;
+	gateOpen = false;
+
+	// Same batch as above, but unordered: slot order wins and the classes are ignored.
+	TEST_ASSERT_TRUE(timer.setTimeout(
+	    []() {
+		    gateEntered = true;
+		    while (!gateOpen) {
+			    delay(1);
+		    }
+	    },
+	    1
+	) > 0);
+	TEST_ASSERT_TRUE(waitUntil([]() { return gateEntered.load(); }));
+	timer.setTimeout([]() { order[fired++] = 'l'; }, 3);
+	timer.setTimeout([]() { order[fired++] = 'e'; }, 1);
+	timer.setTimeout([]() { order[fired++] = 'n'; }, 2);
+	const uint32_t high = timer.setTimeout([]() { order[fired++] = 'H'; }, 4);
+	TEST_ASSERT_TRUE(timer.setPriority(high, ESPTimerPriority::High));
+	delay(40);
+	gateOpen = true;
+
+	TEST_ASSERT_TRUE(waitUntil([]() { return fired == 4; }));
+	TEST_ASSERT_EQUAL_STRING("lenH", order);
+
+	// The four held behind the gate started at least 36 ms after their deadlines; a late board
+	// only adds to that.
+	const ESPTimerLatenessStats stats = timer.latenessStats();
+	TEST_ASSERT_EQUAL_UINT32(5, stats.timeouts.samples);
+	TEST_ASSERT_TRUE(stats.timeouts.maxMs >= 30);
+	TEST_ASSERT_TRUE(stats.timeouts.p50Ms >= 30);
+	TEST_ASSERT_TRUE(stats.timeouts.p50Ms <= stats.timeouts.p99Ms);
+	TEST_ASSERT_TRUE(stats.timeouts.p99Ms <= stats.timeouts.maxMs);
+	TEST_ASSERT_EQUAL_UINT32(0, stats.counters.samples);
+
+	timer.resetLatenessStats();
+	TEST_ASSERT_EQUAL_UINT32(0, timer.latenessStats().timeouts.samples);
+	TEST_ASSERT_EQUAL_UINT32(0, timer.latenessStats().timeouts.maxMs);
+
+	timer.deinit();
+}
+
+void test_lane_budget_splits_batches_and_flags_overruns() {
+	static std::atomic<uint32_t> overruns{0};
+	static std::atomic<uint32_t> overrunId{0};
+	static std::atomic<uint32_t> fires[8] = {};
+	static uint32_t ids[8] = {};
+	static ESPTimer *active = nullptr;
+	overruns = 0;
+	overrunId = 0;
+	for (auto &count : fires) {
+		count = 0;
+	}
+
+	ESPTimer timer;
+	ESPTimerConfig cfg;
+	cfg.maxIntervals = 8;
+	cfg.laneBudgetUs = 3000;
+	cfg.callbackBudgetUs = 1500;
+	cfg.onCallbackOverrun = [](uint32_t id, uint32_t elapsedUs) {
+		overrunId = id;
+		if (elapsedUs > 1500) {
+			overruns++;
+		}
+	};
+	timer.init(cfg);
+	TEST_ASSERT_TRUE(timer.isInitialized());
+	active = &timer;
+
+	// Eight 2 ms callbacks due together: each pass runs two of them and hands the rest back to
+	// the scan, which keeps their deadlines, so none loses a fire. The first callback pauses
+	// the last timer, which is still waiting in the deferred part of the batch and never runs.
+	for (uint32_t i = 0; i < 8; ++i) {
+		ids[i] = timer.setInterval(
+		    [i]() {
+			    if (i == 0) {
+				    active->pauseInterval(ids[7]);
+			    }
+			    const uint32_t start = micros();
+			    while (micros() - start < 2000) {
+			    }
+			    fires[i]++;
+		    },
+		    40
+		);
+		TEST_ASSERT_TRUE(ids[i] > 0);
+	}
+
+	// Every callback runs 2 ms against a 1.5 ms budget, so each fire is also an overrun.
+	TEST_ASSERT_TRUE(waitUntil(
+	    []() {
+		    for (uint32_t i = 0; i < 7; ++i) {
+			    if (fires[i] < 3) {
+				    return false;
+			    }
+		    }
+		    return true;
+	    },
+	    5000
+	));
+	for (uint32_t i = 0; i < 8; ++i) {
+		TEST_ASSERT_TRUE(timer.clearInterval(ids[i]));
+	}
+	TEST_ASSERT_EQUAL_UINT32(0, fires[7]);
+	TEST_ASSERT_TRUE(overruns.load() >= 7 * 3);
+	bool known = false;
+	for (uint32_t id : ids) {
+		known = known || id == overrunId.load();
+	}
+	TEST_ASSERT_TRUE(known);
+
+	timer.deinit();
+}
+
+void test_admission_policies_and_high_water_marks() {
+	static uint32_t alarms[4] = {};
+	static uint32_t lastValue[4] = {};
+	for (uint32_t i = 0; i < 4; ++i) {
+		alarms[i] = 0;
+		lastValue[i] = 0;
+	}
+	ESPTimerConfig cfg;
+	cfg.maxTimeouts = 4;
+	cfg.occupancyHighWaterPct = 75;
+	cfg.latenessHighWaterMs = 20;
+	cfg.onOverload = [](const ESPTimerOverload &overload) {
+		const auto kind = static_cast<uint8_t>(overload.kind);
+		alarms[kind]++;
+		lastValue[kind] = overload.value;
+	};
+	const auto occupancy = static_cast<uint8_t>(ESPTimerOverload::Kind::Occupancy);
+	const auto lateness = static_cast<uint8_t>(ESPTimerOverload::Kind::Lateness);
+	const auto rejected = static_cast<uint8_t>(ESPTimerOverload::Kind::Rejected);
+	const auto evicted = static_cast<uint8_t>(ESPTimerOverload::Kind::Evicted);
+
+	// Reject: the third timer crosses 75%, the fifth is turned away. Dropping below the mark
+	// re-arms the occupancy alarm.
+	ESPTimer timer;
+	timer.init(cfg);
+	TEST_ASSERT_TRUE(timer.isInitialized());
+	uint32_t ids[4] = {};
+	for (auto &id : ids) {
+		id = timer.setTimeout([]() {}, 10000);
+		TEST_ASSERT_TRUE(id > 0);
+	}
+	TEST_ASSERT_EQUAL_UINT32(1, alarms[occupancy]);
+	TEST_ASSERT_EQUAL_UINT32(3, lastValue[occupancy]);
+	TEST_ASSERT_EQUAL_UINT32(0, timer.setTimeout([]() {}, 10000));
+	TEST_ASSERT_EQUAL_UINT32(1, alarms[rejected]);
+	TEST_ASSERT_TRUE(timer.clearTimeout(ids[0]));
+	TEST_ASSERT_TRUE(timer.clearTimeout(ids[1]));
+	TEST_ASSERT_TRUE(timer.setTimeout([]() {}, 10000) > 0);
+	TEST_ASSERT_EQUAL_UINT32(2, alarms[occupancy]);
+	ESPTimerLaneLoad load = timer.loadStats().timeouts;
+	TEST_ASSERT_EQUAL_UINT32(4, load.peakSlots);
+	TEST_ASSERT_EQUAL_UINT32(2, load.occupancyAlarms);
+	TEST_ASSERT_EQUAL_UINT32(1, load.rejected);
+	timer.deinit();
+
+	// EvictLow: the Low-class timer with the most distant deadline makes room.
+	cfg.maxTimeouts = 3;
+	cfg.admission = ESPTimerAdmission::EvictLow;
+	timer.init(cfg);
+	const uint32_t soon = timer.setTimeout([]() {}, 10000);
+	const uint32_t later = timer.setTimeout([]() {}, 20000);
+	TEST_ASSERT_TRUE(timer.setTimeout([]() {}, 30000) > 0); // Normal, never evicted
+	TEST_ASSERT_TRUE(timer.setPriority(soon, ESPTimerPriority::Low));
+	TEST_ASSERT_TRUE(timer.setPriority(later, ESPTimerPriority::Low));
+	TEST_ASSERT_TRUE(timer.setTimeout([]() {}, 100) > 0);
+	TEST_ASSERT_EQUAL_UINT32(later, lastValue[evicted]);
+	TEST_ASSERT_EQUAL_UINT8(
+	    static_cast<uint8_t>(ESPTimerStatus::Invalid),
+	    static_cast<uint8_t>(timer.getStatus(later))
+	);
+	TEST_ASSERT_TRUE(timer.setTimeout([]() {}, 100) > 0);
+	TEST_ASSERT_EQUAL_UINT32(soon, lastValue[evicted]);
+	TEST_ASSERT_EQUAL_UINT32(0, timer.setTimeout([]() {}, 100));
+	TEST_ASSERT_EQUAL_UINT32(2, timer.loadStats().timeouts.evicted);
+	timer.deinit();
+
+	// Overflow: two reserve slots beyond the regular two, then rejection. A callback held
+	// behind a busy one raises the lateness alarm once.
+	cfg.maxTimeouts = 2;
+	cfg.admission = ESPTimerAdmission::Overflow;
+	cfg.overflowSlots = 2;
+	timer.init(cfg);
+	TEST_ASSERT_EQUAL_UINT32(4, timer.memoryFootprint().timeouts.slots);
+	TEST_ASSERT_TRUE(timer.setTimeout([]() { delay(40); }, 1) > 0);
+	TEST_ASSERT_TRUE(timer.setTimeout([]() {}, 5) > 0);
+	TEST_ASSERT_TRUE(timer.setTimeout([]() {}, 5) > 0);
+	TEST_ASSERT_TRUE(timer.setTimeout([]() {}, 5) > 0);
+	TEST_ASSERT_EQUAL_UINT32(0, timer.setTimeout([]() {}, 5));
+	delay(100);
+	load = timer.loadStats().timeouts;
+	TEST_ASSERT_EQUAL_UINT32(2, load.overflowed);
+	TEST_ASSERT_EQUAL_UINT32(1, load.latenessAlarms);
+	TEST_ASSERT_EQUAL_UINT32(1, alarms[lateness]);
+	TEST_ASSERT_TRUE(lastValue[lateness] >= 20);
+	timer.deinit();
+}
+
+void test_elastic_lanes_grow_and_reclaim() {
+	ESPTimer timer;
+	ESPTimerConfig cfg;
+	cfg.maxTimeouts = 4;
+	cfg.elasticChunkSlots = 4;
+	cfg.elasticMaxSlots = 12;
+	cfg.elasticReclaimMs = 30;
+	timer.init(cfg);
+	TEST_ASSERT_TRUE(timer.isInitialized());
+	TEST_ASSERT_EQUAL_UINT32(4, timer.memoryFootprint().timeouts.slots);
+	const size_t stagingBytes = timer.memoryFootprint().timeouts.dispatchBytes;
+
+	// A callback keeps running from its slot while the lane grows to its limit around it.
+	static volatile uint32_t ran = 0;
+	ran = 0;
+	const uint32_t slowId = timer.setTimeout(
+	    []() {
+		    delay(40);
+		    ran = ran + 1;
+	    },
+	    1
+	);
+	TEST_ASSERT_TRUE(slowId > 0);
+	delay(10);
+	uint32_t ids[11] = {};
+	for (auto &id : ids) {
+		id = timer.setTimeout([]() {}, 10000);
+		TEST_ASSERT_TRUE(id > 0);
+	}
+	TEST_ASSERT_EQUAL_UINT32(12, timer.memoryFootprint().timeouts.slots);
+	TEST_ASSERT_EQUAL_UINT32(0, timer.setTimeout([]() {}, 10000));
+	delay(60);
+	TEST_ASSERT_EQUAL_UINT32(1, ran);
+	// The worker sized its staging buffer to the grown lane on its next pass.
+	TEST_ASSERT_EQUAL_UINT32(3 * stagingBytes, timer.memoryFootprint().timeouts.dispatchBytes);
+
+	// Empty chunks above the starting size are freed one idle period at a time.
+	for (const auto id : ids) {
+		TEST_ASSERT_TRUE(timer.clearTimeout(id));
+	}
+	delay(150);
+	TEST_ASSERT_EQUAL_UINT32(4, timer.memoryFootprint().timeouts.slots);
+
+	// Regrown slots never reissue an ID that was handed out before the reclaim.
+	const uint32_t stale = ids[10];
+	for (auto &id : ids) {
+		id = timer.setTimeout([]() {}, 10000);
+		TEST_ASSERT_TRUE(id > 0);
+		TEST_ASSERT_TRUE(id != stale);
+	}
+	TEST_ASSERT_EQUAL_UINT8(
+	    static_cast<uint8_t>(ESPTimerStatus::Invalid),
+	    static_cast<uint8_t>(timer.getStatus(stale))
+	);
+	timer.deinit();
+}
+
+void test_reconfigure_keeps_timers_and_ids() {
+	ESPTimer timer;
+	ESPTimerConfig cfg;
+	cfg.maxTimeouts = 2;
+	cfg.maxIntervals = 2;
+	cfg.stealCallbacks = true;
+	timer.init(cfg);
+	TEST_ASSERT_TRUE(timer.isInitialized());
+	const ESPTimerMemoryFootprint before = timer.memoryFootprint();
+
+	static volatile bool fired = false;
+	static std::atomic<uint32_t> ticks{0};
+	fired = false;
+	ticks = 0;
+	const uint32_t pending = timer.setTimeout([]() { fired = true; }, 150);
+	const uint32_t parked = timer.setTimeout([]() {}, 10000);
+	const uint32_t intervalId = timer.setInterval([]() { ticks++; }, 20);
+	TEST_ASSERT_TRUE(pending > 0 && parked > 0 && intervalId > 0);
+	TEST_ASSERT_EQUAL_UINT32(0, timer.setTimeout([]() {}, 10000));
+
+	// More timeout slots, a new interval priority and bigger timeout and counter stacks.
+	ESPTimerConfig next = cfg;
+	next.maxTimeouts = 4;
+	next.priorityInterval = 3;
+	next.stackSizeTimeout = 6144;
+	next.stackSizeCounter = 6144;
+	TEST_ASSERT_TRUE(timer.reconfigure(next));
+	const ESPTimerMemoryFootprint after = timer.memoryFootprint();
+	TEST_ASSERT_EQUAL_UINT32(4, after.timeouts.slots);
+	// Staging and the work-stealing deques follow the new capacity.
+	TEST_ASSERT_EQUAL_UINT32(2 * before.timeouts.dispatchBytes, after.timeouts.dispatchBytes);
+	TEST_ASSERT_TRUE(after.executorBytes >= before.executorBytes);
+	TEST_ASSERT_EQUAL(before.executorBytes > 0, after.executorBytes > before.executorBytes);
+	TEST_ASSERT_EQUAL_UINT8(
+	    static_cast<uint8_t>(ESPTimerStatus::Running),
+	    static_cast<uint8_t>(timer.getStatus(pending))
+	);
+	const uint32_t extra[2] = {
+	    timer.setTimeout([]() {}, 10000),
+	    timer.setTimeout([]() {}, 10000),
+	};
+	TEST_ASSERT_TRUE(extra[0] > 0 && extra[1] > 0);
+	delay(200);
+	TEST_ASSERT_TRUE(fired);
+	const uint32_t seen = ticks.load();
+	TEST_ASSERT_TRUE(seen >= 5);
+
+	// Shrinking below a live timer and changing the shard layout are refused.
+	next.maxTimeouts = 2;
+	TEST_ASSERT_FALSE(timer.reconfigure(next));
+	ESPTimerConfig sharded = next;
+	sharded.maxTimeouts = 4;
+	sharded.shardPerCore = !next.shardPerCore;
+	TEST_ASSERT_FALSE(timer.reconfigure(sharded));
+	TEST_ASSERT_EQUAL_UINT32(4, timer.memoryFootprint().timeouts.slots);
+
+	TEST_ASSERT_TRUE(timer.clearTimeout(extra[0]));
+	TEST_ASSERT_TRUE(timer.clearTimeout(extra[1]));
+	TEST_ASSERT_TRUE(timer.reconfigure(next));
+	TEST_ASSERT_EQUAL_UINT32(2, timer.memoryFootprint().timeouts.slots);
+	TEST_ASSERT_EQUAL_UINT8(
+	    static_cast<uint8_t>(ESPTimerStatus::Running),
+	    static_cast<uint8_t>(timer.getStatus(parked))
+	);
+	TEST_ASSERT_TRUE(timer.clearTimeout(parked));
+	delay(50);
+	TEST_ASSERT_TRUE(ticks.load() > seen);
+
+	// A lane or worker still busy after the timeout is left as it was, and the same call goes
+	// through once it is idle again.
+	static std::atomic<bool> gateOpen{false};
+	static std::atomic<bool> gateEntered{false};
+	gateOpen = false;
+	gateEntered = false;
+	const uint32_t gate = timer.setTimeout(
+	    []() {
+		    gateEntered = true;
+		    while (!gateOpen) {
+			    delay(1);
+		    }
+	    },
+	    1
+	);
+	TEST_ASSERT_TRUE(gate > 0);
+	TEST_ASSERT_TRUE(waitUntil([]() { return gateEntered.load(); }));
+	ESPTimerConfig grown = next;
+	grown.maxTimeouts = 3;
+	TEST_ASSERT_FALSE(timer.reconfigure(grown));
+	TEST_ASSERT_EQUAL_UINT32(2, timer.memoryFootprint().timeouts.slots);
+	ESPTimerConfig restacked = next;
+	restacked.stackSizeTimeout = 8192;
+	TEST_ASSERT_FALSE(timer.reconfigure(restacked));
+	gateOpen = true;
+	TEST_ASSERT_TRUE(waitUntil([&]() { return timer.getStatus(gate) == ESPTimerStatus::Invalid; }));
+	TEST_ASSERT_TRUE(timer.reconfigure(restacked));
+	TEST_ASSERT_TRUE(timer.reconfigure(grown));
+	TEST_ASSERT_EQUAL_UINT32(3, timer.memoryFootprint().timeouts.slots);
+	timer.deinit();
+}
+
+void test_wait_for_blocks_until_fire_or_clear() {
+	ESPTimer timer;
+	ESPTimerConfig cfg;
+	cfg.maxTimeouts = 2;
+	cfg.maxIntervals = 1;
+	timer.init(cfg);
+	TEST_ASSERT_TRUE(timer.isInitialized());
+
+	// The wait ends only after the callback has returned.
+	static volatile bool ran = false;
+	ran = false;
+	const uint32_t timeoutId = timer.setTimeout([]() { ran = true; }, 30);
+	TEST_ASSERT_TRUE(timer.waitFor(timeoutId, pdMS_TO_TICKS(500)));
+	TEST_ASSERT_TRUE(ran);
+	TEST_ASSERT_FALSE(timer.waitFor(timeoutId, pdMS_TO_TICKS(10)));
+
+	const uint32_t intervalId = timer.setInterval([]() {}, 10);
+	TEST_ASSERT_TRUE(timer.waitFor(intervalId, pdMS_TO_TICKS(200)));
+	TEST_ASSERT_TRUE(timer.waitFor(intervalId, pdMS_TO_TICKS(200)));
+	TEST_ASSERT_TRUE(timer.clearInterval(intervalId));
+
+	// A timeout leaves the timer untouched; clearing it releases a task still waiting.
+	const uint32_t slowId = timer.setTimeout([]() {}, 10000);
+	TEST_ASSERT_FALSE(timer.waitFor(slowId, pdMS_TO_TICKS(20)));
+	TEST_ASSERT_EQUAL_UINT8(
+	    static_cast<uint8_t>(ESPTimerStatus::Running),
+	    static_cast<uint8_t>(timer.getStatus(slowId))
+	);
+
+	struct Waiter {
+		ESPTimer *timer;
+		uint32_t id;
+		volatile int result;
+	};
+	static Waiter waiter;
+	waiter = {&timer, slowId, -1};
+	TaskHandle_t handle = nullptr;
+	xTaskCreatePinnedToCore(
+	    [](void *arg) {
+		    auto &w = *static_cast<Waiter *>(arg);
+		    w.result = w.timer->waitFor(w.id) ? 1 : 0;
+		    vTaskDelete(nullptr);
+	    },
+	    "waiter",
+	    4096,
+	    &waiter,
+	    1,
+	    &handle,
+	    tskNO_AFFINITY
+	);
+	delay(30);
+	TEST_ASSERT_EQUAL_INT(-1, waiter.result);
+	TEST_ASSERT_FALSE(timer.waitFor(slowId, pdMS_TO_TICKS(10))); // one waiter per timer
+	TEST_ASSERT_TRUE(timer.clearTimeout(slowId));
+	delay(30);
+	TEST_ASSERT_EQUAL_INT(0, waiter.result);
+
+	timer.deinit();
+}
+
+#if defined(ESPTIMER_HAS_COROUTINES)
+namespace {
+std::atomic<uint32_t> coroutineSteps{0};
+std::atomic<uint32_t> coroutinesCancelled{0};
+
+// Results are bound to a local first: GCC 12 miscompiles `co_await` used directly as a loop or
+// if condition.
+ESPTimerTask sleeper(ESPTimer &timer) {
+	for (int i = 0; i < 3; ++i) {
+		const bool slept = co_await timer.sleepFor(10);
+		if (!slept) {
+			co_return;
+		}
+		coroutineSteps++;
+	}
+}
+
+ESPTimerTask ticker(ESPTimer &timer, uint32_t intervalId) {
+	for (;;) {
+		const bool fired = co_await timer.nextTick(intervalId);
+		if (!fired) {
+			break;
+		}
+		coroutineSteps++;
+	}
+	coroutinesCancelled++;
+}
+} // namespace
+
+void test_coroutines_resume_from_timer_lanes() {
+	ESPTimer timer;
+	ESPTimerConfig cfg;
+	cfg.maxTimeouts = 50;
+	cfg.maxIntervals = 1;
+	timer.init(cfg);
+	TEST_ASSERT_TRUE(timer.isInitialized());
+
+	// Each sleeping coroutine holds one timeout slot and no task of its own.
+	coroutineSteps = 0;
+	for (int i = 0; i < 50; ++i) {
+		sleeper(timer);
+	}
+	delay(150);
+	TEST_ASSERT_EQUAL_UINT32(150, coroutineSteps.load());
+
+	// Many coroutines can follow one interval; clearing it resumes them with false.
+	coroutineSteps = 0;
+	coroutinesCancelled = 0;
+	const uint32_t intervalId = timer.setInterval([]() {}, 20);
+	for (int i = 0; i < 4; ++i) {
+		ticker(timer, intervalId);
+	}
+	delay(70);
+	TEST_ASSERT_TRUE(coroutineSteps.load() >= 8);
+	TEST_ASSERT_TRUE(timer.clearInterval(intervalId));
+	delay(20);
+	TEST_ASSERT_EQUAL_UINT32(4, coroutinesCancelled.load());
+
+	// Awaiting an unknown timer does not suspend.
+	ticker(timer, intervalId);
+	TEST_ASSERT_EQUAL_UINT32(5, coroutinesCancelled.load());
+
+	timer.deinit();
+}
+#endif
+
+void test_staggered_and_phased_intervals_spread_their_fires() {
+	ESPTimer timer;
+	ESPTimerConfig cfg;
+	cfg.maxIntervals = 5;
+	cfg.staggerIntervals = true;
+	timer.init(cfg);
+	TEST_ASSERT_TRUE(timer.isInitialized());
+
+	static uint32_t startMs = 0;
+	static volatile uint32_t firstFireMs[5] = {};
+	static volatile uint32_t seventhFireMs[5] = {};
+	static std::atomic<uint32_t> fires[5] = {};
+	for (int i = 0; i < 5; ++i) {
+		firstFireMs[i] = 0;
+		seventhFireMs[i] = 0;
+		fires[i] = 0;
+	}
+
+	// The phased interval stalls the lane for 80 ms on its second fire, so the intervals due
+	// meanwhile fire up to 60 ms late once.
+	auto recordFirstFire = [](int slot) {
+		return [slot]() {
+			const uint32_t fire = ++fires[slot];
+			if (fire == 1) {
+				firstFireMs[slot] = millis();
+			} else if (fire == 2 && slot == 4) {
+				delay(80);
+			} else if (fire == 7) {
+				seventhFireMs[slot] = millis();
+			}
+		};
+	};
+
+	// Same-period intervals get 0, 1/2, 1/4 and 3/4 of the period; the phased one keeps 30 ms.
+	startMs = millis();
+	const uint32_t ids[5] = {
+	    timer.setInterval(recordFirstFire(0), 100),
+	    timer.setInterval(recordFirstFire(1), 100),
+	    timer.setInterval(recordFirstFire(2), 100),
+	    timer.setInterval(recordFirstFire(3), 100),
+	    timer.setPhasedInterval(recordFirstFire(4), 100, 30),
+	};
+	for (uint32_t id : ids) {
+		TEST_ASSERT_TRUE(id > 0);
+	}
+
+	delay(220);
+	const uint32_t expected[5] = {100, 150, 125, 175, 130};
+	for (int i = 0; i < 5; ++i) {
+		TEST_ASSERT_TRUE(firstFireMs[i] != 0);
+		TEST_ASSERT_UINT32_WITHIN(10, expected[i], firstFireMs[i] - startMs);
+	}
+
+	// Late fires do not move the schedule: the seventh fire is still on the original grid.
+	TEST_ASSERT_TRUE(waitUntil([]() {
+		for (const auto &fire : fires) {
+			if (fire < 7) {
+				return false;
+			}
+		}
+		return true;
+	}));
+	for (int i = 0; i < 5; ++i) {
+		TEST_ASSERT_UINT32_WITHIN(20, expected[i] + 600, seventhFireMs[i] - startMs);
+	}
+
+	timer.deinit();
+}
+
+void test_cyclic_executive_runs_frames_in_table_order() {
+	ESPTimer timer;
+	timer.init();
+	TEST_ASSERT_TRUE(timer.isInitialized());
+
+	static char order[16] = {};
+	static volatile uint32_t calls = 0;
+	calls = 0;
+	auto record = [](char name) {
+		return [name]() {
+			if (calls < sizeof(order)) {
+				order[calls] = name;
+			}
+			calls = calls + 1;
+		};
+	};
+
+	// Minor frame gcd(10, 20, 40, 5) = 5 ms, major frame 40 ms.
+	const ESPTimerCyclicTask table[] = {
+	    {10, 0, record('A')},
+	    {20, 5, record('B')},
+	    {40, 10, record('C')},
+	};
+	TEST_ASSERT_FALSE(timer.startCyclic(table, 0));
+	if (portTICK_PERIOD_MS > 1) {
+		const ESPTimerCyclicTask offGrid[] = {{portTICK_PERIOD_MS + 1, 0, record('X')}};
+		TEST_ASSERT_FALSE(timer.startCyclic(offGrid));
+	}
+	TEST_ASSERT_TRUE(timer.startCyclic(table));
+	TEST_ASSERT_FALSE(timer.startCyclic(table));
+
+	delay(100);
+	const ESPTimerCyclicStats stats = timer.cyclicStats();
+	TEST_ASSERT_EQUAL_UINT32(5, stats.minorFrameMs);
+	TEST_ASSERT_EQUAL_UINT32(40, stats.majorFrameMs);
+	TEST_ASSERT_TRUE(stats.frames >= 16);
+	TEST_ASSERT_EQUAL_UINT32(0, stats.overruns);
+	TEST_ASSERT_EQUAL_MEMORY("ABACABAABACA", order, 12);
+	timer.stopCyclic();
+	TEST_ASSERT_EQUAL_UINT32(0, timer.cyclicStats().frames);
+
+	// A callback longer than its frame is reported instead of shifting the grid.
+	static volatile uint32_t overrunFrames = 0;
+	overrunFrames = 0;
+	ESPTimerCyclicConfig cyclicCfg;
+	cyclicCfg.onOverrun = [](uint32_t, uint32_t) { overrunFrames = overrunFrames + 1; };
+	const ESPTimerCyclicTask slow[] = {{5, 0, []() { delay(7); }}};
+	TEST_ASSERT_TRUE(timer.startCyclic(slow, cyclicCfg));
+	delay(50);
+	TEST_ASSERT_TRUE(timer.cyclicStats().overruns > 0);
+	TEST_ASSERT_TRUE(overrunFrames > 0);
+
+	timer.deinit();
+	TEST_ASSERT_FALSE(timer.startCyclic(slow));
+}
+
+void test_core_shards_accept_cross_core_control() {
+	ESPTimer timer;
+	ESPTimerConfig cfg;
+	cfg.maxTimeouts = 2;
+	cfg.maxIntervals = 2;
+	cfg.maxCounters = 1;
+	cfg.shardPerCore = true;
+	timer.init(cfg);
+	TEST_ASSERT_TRUE(timer.isInitialized());
+
+	static volatile uint32_t localHits = 0;
+	static volatile uint32_t remoteHits = 0;
+	localHits = 0;
+	remoteHits = 0;
+
+	const int8_t here = static_cast<int8_t>(xPortGetCoreID());
+	const int8_t other = here == 0 ? 1 : 0;
+	const uint32_t localId = timer.setInterval([]() { localHits = localHits + 1; }, 5, here);
+	const uint32_t remoteId = timer.setInterval([]() { remoteHits = remoteHits + 1; }, 5, other);
+	TEST_ASSERT_TRUE(localId > 0);
+	TEST_ASSERT_TRUE(remoteId > 0);
+	TEST_ASSERT_TRUE(localId != remoteId);
+
+	TEST_ASSERT_TRUE(waitUntil([]() { return localHits > 0 && remoteHits > 0; }));
+
+	// Timing changes for the other core's shard are queued and applied by its worker; status
+	// changes are final as soon as the call returns.
+	TEST_ASSERT_TRUE(timer.setIntervalPeriod(remoteId, 4));
+	TEST_ASSERT_TRUE(timer.pauseInterval(remoteId));
+	const uint32_t pausedHits = remoteHits;
+	TEST_ASSERT_EQUAL_UINT8(
+	    static_cast<uint8_t>(ESPTimerStatus::Paused),
+	    static_cast<uint8_t>(timer.getStatus(remoteId))
+	);
+	TEST_ASSERT_FALSE(timer.pauseInterval(remoteId));
+	// The local interval is the clock: over ten of its periods the paused one adds at most the
+	// callback that was already running when the pause landed.
+	const uint32_t localMark = localHits;
+	TEST_ASSERT_TRUE(waitUntil([localMark]() { return localHits >= localMark + 10; }));
+	TEST_ASSERT_TRUE(remoteHits - pausedHits <= 1);
+
+	TEST_ASSERT_TRUE(timer.clearInterval(remoteId));
+	TEST_ASSERT_FALSE(timer.isRunning(remoteId));
+	TEST_ASSERT_EQUAL_UINT8(
+	    static_cast<uint8_t>(ESPTimerStatus::Invalid),
+	    static_cast<uint8_t>(timer.getStatus(remoteId))
+	);
+	TEST_ASSERT_FALSE(timer.pauseInterval(remoteId));
+	TEST_ASSERT_TRUE(timer.isRunning(localId));
+
+	timer.deinit();
+}
+
+void test_work_stealing_runs_each_callback_once() {
+	ESPTimer timer;
+	ESPTimerConfig cfg;
+	cfg.maxTimeouts = 65;
+	cfg.stealCallbacks = true;
+	timer.init(cfg);
+	TEST_ASSERT_TRUE(timer.isInitialized());
+
+	// Single-core chips ignore stealCallbacks and run every batch on the lane worker.
+	const bool dualCore = portNUM_PROCESSORS > 1;
+	TEST_ASSERT_EQUAL(dualCore, timer.memoryFootprint().executorBytes > 0);
+
+	static std::atomic<uint32_t> calls{0};
+	static std::atomic<uint32_t> coreMask{0};
+	static std::atomic<bool> gateOpen{false};
+	static std::atomic<bool> gateEntered{false};
+	static uint32_t waitForOtherCoreUs = 0;
+	static uint8_t hits[64] = {};
+	calls = 0;
+	coreMask = 0;
+	gateOpen = false;
+	gateEntered = false;
+	for (auto &hit : hits) {
+		hit = 0;
+	}
+	// On dual-core chips each callback keeps its core busy until the other core has run one
+	// too (or 200 ms passed), so the burst outlasts any scheduling delay of the executor.
+	waitForOtherCoreUs = dualCore ? 200000 : 500;
+
+	// Block the timeout worker so every timer below is due in the same scan.
+	TEST_ASSERT_TRUE(timer.setTimeout(
+	    []() {
+		    gateEntered = true;
+		    while (!gateOpen) {
+			    delay(1);
+		    }
+	    },
+	    1
+	) > 0);
+	TEST_ASSERT_TRUE(waitUntil([]() { return gateEntered.load(); }));
+	for (uint32_t i = 0; i < 64; ++i) {
+		TEST_ASSERT_TRUE(timer.setTimeout(
+		    [i]() {
+			    coreMask |= 1u << xPortGetCoreID();
+			    const uint32_t start = micros();
+			    while (micros() - start < 500 ||
+			           (coreMask.load() != 0x3 && micros() - start < waitForOtherCoreUs)) {
+			    }
+			    hits[i] = hits[i] + 1;
+			    calls++;
+		    },
+		    1
+		) > 0);
+	}
+	delay(5);
+	gateOpen = true;
+
+	TEST_ASSERT_TRUE(waitUntil([]() { return calls.load() == 64; }));
+	for (uint8_t hit : hits) {
+		TEST_ASSERT_EQUAL_UINT8(1, hit);
+	}
+	TEST_ASSERT_EQUAL_UINT32(dualCore ? 0x3 : 0x1, coreMask.load());
+
+	timer.deinit();
+}
+
 void test_deinit_pre_init_is_safe_and_idempotent() {
 	ESPTimer timer;
 
@@ -123,6 +1377,68 @@ void test_deinit_pre_init_is_safe_and_idempotent() {
 	TEST_ASSERT_FALSE(timer.isInitialized());
 }
 
+void test_deinit_joins_workers_and_reports_drain() {
+	ESPTimer timer;
+	TEST_ASSERT_TRUE(timer.deinit(pdMS_TO_TICKS(10)));
+
+	ESPTimerConfig cfg;
+	cfg.stealCallbacks = true;
+	timer.init(cfg);
+	TEST_ASSERT_TRUE(timer.isInitialized());
+
+	// A callback in flight is waited for, not cut off.
+	static std::atomic<bool> started{false};
+	static std::atomic<bool> finished{false};
+	started = false;
+	finished = false;
+	const uint32_t id = timer.setTimeout(
+	    []() {
+		    started = true;
+		    delay(50);
+		    finished = true;
+	    },
+	    1
+	);
+	TEST_ASSERT_TRUE(id > 0);
+	TEST_ASSERT_TRUE(waitUntil([]() { return started.load(); }));
+	TEST_ASSERT_TRUE(timer.deinit(pdMS_TO_TICKS(2000)));
+	TEST_ASSERT_TRUE(finished);
+	TEST_ASSERT_FALSE(timer.isInitialized());
+
+	// Idle workers are joined as soon as they exit, well before the timeout runs out.
+	timer.init(cfg);
+	TEST_ASSERT_TRUE(timer.isInitialized());
+	const uint32_t start = millis();
+	TEST_ASSERT_TRUE(timer.deinit(pdMS_TO_TICKS(2000)));
+	TEST_ASSERT_TRUE(millis() - start < 1000);
+
+	// A callback still running at the deadline is left alone: deinit() reports it, init() is
+	// refused meanwhile, and a later deinit() finishes the job.
+	static std::atomic<bool> gateOpen{false};
+	started = false;
+	gateOpen = false;
+	timer.init(cfg);
+	TEST_ASSERT_TRUE(timer.setTimeout(
+	    []() {
+		    started = true;
+		    while (!gateOpen) {
+			    delay(1);
+		    }
+	    },
+	    1
+	));
+	TEST_ASSERT_TRUE(waitUntil([]() { return started.load(); }));
+	TEST_ASSERT_FALSE(timer.deinit(pdMS_TO_TICKS(20)));
+	TEST_ASSERT_FALSE(timer.isInitialized());
+	timer.init(cfg);
+	TEST_ASSERT_FALSE(timer.isInitialized());
+	gateOpen = true;
+	TEST_ASSERT_TRUE(timer.deinit(pdMS_TO_TICKS(2000)));
+	timer.init(cfg);
+	TEST_ASSERT_TRUE(timer.isInitialized());
+	TEST_ASSERT_TRUE(timer.deinit(pdMS_TO_TICKS(2000)));
+}
+
 void test_reinit_lifecycle() {
 	ESPTimer timer;
 
@@ -152,7 +1468,32 @@ void setup() {
 	RUN_TEST(test_api_compiles);
 	RUN_TEST(test_schedule_before_init_returns_invalid_id);
 	RUN_TEST(test_capacity_limits_return_zero_without_corrupting_existing_timers);
+	RUN_TEST(test_released_slots_are_reused_immediately);
+	RUN_TEST(test_stale_ids_and_memory_footprint);
+	RUN_TEST(test_status_queries_follow_pause_and_clear);
+	RUN_TEST(test_batched_dispatch_completes_every_timer);
+	RUN_TEST(test_restart_and_reschedule_keep_ids);
+	RUN_TEST(test_debounce_and_throttle_reuse_their_slot);
+	RUN_TEST(test_counter_lane_ticks_per_timer);
+	RUN_TEST(test_counter_ticks_align_to_deadline_boundaries);
+	RUN_TEST(test_rate_limited_and_adaptive_ms_counters);
+	RUN_TEST(test_event_timers_post_to_queues_and_notifications);
+	RUN_TEST(test_priority_classes_order_each_batch);
+	RUN_TEST(test_lateness_stats_and_slot_order_dispatch);
+	RUN_TEST(test_lane_budget_splits_batches_and_flags_overruns);
+	RUN_TEST(test_admission_policies_and_high_water_marks);
+	RUN_TEST(test_elastic_lanes_grow_and_reclaim);
+	RUN_TEST(test_reconfigure_keeps_timers_and_ids);
+	RUN_TEST(test_wait_for_blocks_until_fire_or_clear);
+#if defined(ESPTIMER_HAS_COROUTINES)
+	RUN_TEST(test_coroutines_resume_from_timer_lanes);
+#endif
+	RUN_TEST(test_staggered_and_phased_intervals_spread_their_fires);
+	RUN_TEST(test_cyclic_executive_runs_frames_in_table_order);
+	RUN_TEST(test_core_shards_accept_cross_core_control);
+	RUN_TEST(test_work_stealing_runs_each_callback_once);
 	RUN_TEST(test_deinit_pre_init_is_safe_and_idempotent);
+	RUN_TEST(test_deinit_joins_workers_and_reports_drain);
 	RUN_TEST(test_reinit_lifecycle);
 	UNITY_END();
 }
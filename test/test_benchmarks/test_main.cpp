@@ -0,0 +1,216 @@
+#include <Arduino.h>
+#include <ESPTimer.h>
+#include <atomic>
+#include <stdio.h>
+#include <unity.h>
+
+// Timing benchmarks. They assert only coarse sanity bounds and report the measured numbers
+// through TEST_MESSAGE so runs on different boards can be compared.
+
+namespace {
+void busyWaitUs(uint32_t us) {
+	const uint32_t start = micros();
+	while (micros() - start < us) {
+	}
+}
+
+void reportUs(const char *label, uint32_t value) {
+	char line[96];
+	snprintf(line, sizeof(line), "%s: %lu us", label, static_cast<unsigned long>(value));
+	TEST_MESSAGE(line);
+}
+} // namespace
+
+void bench_ms_lane_jitter_with_saturated_lanes() {
+	ESPTimer timer;
+	ESPTimerConfig cfg;
+	cfg.maxTimeouts = 32;
+	cfg.maxIntervals = 32;
+	cfg.maxCounters = 9;
+	timer.init(cfg);
+	TEST_ASSERT_TRUE(timer.isInitialized());
+
+	// Saturate the interval lane and load the counter lane with slow sec/min counters.
+	for (int i = 0; i < 16; ++i) {
+		TEST_ASSERT_TRUE(timer.setInterval([]() { busyWaitUs(200); }, 1) > 0);
+	}
+	for (int i = 0; i < 4; ++i) {
+		TEST_ASSERT_TRUE(timer.setSecCounter([](int) { busyWaitUs(500); }, 5000) > 0);
+		TEST_ASSERT_TRUE(timer.setMinCounter([](int) {}, 60000) > 0);
+	}
+
+	static volatile uint32_t lastTickUs = 0;
+	static volatile uint32_t maxGapUs = 0;
+	static volatile uint32_t ticks = 0;
+	static volatile uint64_t gapSumUs = 0;
+	lastTickUs = 0;
+	maxGapUs = 0;
+	ticks = 0;
+	gapSumUs = 0;
+
+	const uint32_t runMs = 2000;
+	const uint32_t msId = timer.setMsCounter(
+	    [](uint32_t) {
+		    const uint32_t now = micros();
+		    if (lastTickUs != 0) {
+			    const uint32_t gap = now - lastTickUs;
+			    gapSumUs = gapSumUs + gap;
+			    if (gap > maxGapUs) {
+				    maxGapUs = gap;
+			    }
+		    }
+		    lastTickUs = now;
+		    ticks = ticks + 1;
+	    },
+	    runMs
+	);
+	TEST_ASSERT_TRUE(msId > 0);
+
+	// Churn the timeout lane and poll status from this task while the ms lane runs.
+	const uint32_t start = millis();
+	while (millis() - start < runMs) {
+		const uint32_t id = timer.setTimeout([]() {}, 50);
+		timer.pauseTimer(id);
+		timer.getStatus(id);
+		timer.clearTimeout(id);
+	}
+
+	const uint32_t observed = ticks;
+	TEST_ASSERT_TRUE(observed > 1);
+	reportUs("ms lane mean gap", static_cast<uint32_t>(gapSumUs / (observed - 1)));
+	reportUs("ms lane max gap", maxGapUs);
+
+	timer.deinit();
+}
+
+namespace {
+std::atomic<uint32_t> firstStartUs{0};
+std::atomic<uint32_t> lastEndUs{0};
+std::atomic<uint32_t> finished{0};
+
+// Time from the first of 1,000 simultaneous expirations starting to the last one finishing.
+void measureMakespanUs(bool stealCallbacks, uint32_t &makespanUs) {
+	constexpr uint32_t kTimers = 1000;
+	ESPTimer timer;
+	ESPTimerConfig cfg;
+	cfg.maxTimeouts = kTimers + 1;
+	cfg.stealCallbacks = stealCallbacks;
+	timer.init(cfg);
+	TEST_ASSERT_TRUE(timer.isInitialized());
+
+	firstStartUs = 0;
+	lastEndUs = 0;
+	finished = 0;
+
+	// Hold the timeout worker in a callback while the batch is scheduled, so every timer is
+	// due in the same scan.
+	TEST_ASSERT_TRUE(timer.setTimeout([]() { delay(200); }, 1) > 0);
+	delay(10);
+	for (uint32_t i = 0; i < kTimers; ++i) {
+		const uint32_t id = timer.setTimeout(
+		    []() {
+			    uint32_t expected = 0;
+			    firstStartUs.compare_exchange_strong(expected, micros());
+			    busyWaitUs(100);
+			    const uint32_t end = micros();
+			    uint32_t last = lastEndUs.load();
+			    while (end > last && !lastEndUs.compare_exchange_weak(last, end)) {
+			    }
+			    finished++;
+		    },
+		    1
+		);
+		TEST_ASSERT_TRUE(id > 0);
+	}
+
+	const uint32_t start = millis();
+	while (finished.load() < kTimers && millis() - start < 5000) {
+		delay(10);
+	}
+	TEST_ASSERT_EQUAL_UINT32(kTimers, finished.load());
+	timer.deinit();
+	makespanUs = lastEndUs.load() - firstStartUs.load();
+}
+} // namespace
+
+void bench_makespan_of_1000_simultaneous_expirations() {
+	uint32_t serialUs = 0;
+	uint32_t stolenUs = 0;
+	measureMakespanUs(false, serialUs);
+	measureMakespanUs(true, stolenUs);
+	reportUs("1000 expirations, one lane task", serialUs);
+	reportUs("1000 expirations, work stealing", stolenUs);
+}
+
+namespace {
+// p99 start lateness of 200 timeouts that expire behind a busy callback. They are created
+// latest deadline first, so slot order runs the most overdue timers last.
+void measureBurstLateness(bool orderDispatch, ESPTimerLateness &lateness) {
+	constexpr uint32_t kTimers = 200;
+	ESPTimer timer;
+	ESPTimerConfig cfg;
+	cfg.maxTimeouts = kTimers + 1;
+	cfg.orderDispatch = orderDispatch;
+	timer.init(cfg);
+	TEST_ASSERT_TRUE(timer.isInitialized());
+
+	finished = 0;
+	TEST_ASSERT_TRUE(timer.setTimeout([]() { delay(60); }, 1) > 0);
+	delay(5);
+	timer.resetLatenessStats();
+	for (uint32_t i = 0; i < kTimers; ++i) {
+		const uint32_t id = timer.setTimeout(
+		    []() {
+			    busyWaitUs(200);
+			    finished++;
+		    },
+		    50 - i / 4
+		);
+		TEST_ASSERT_TRUE(id > 0);
+	}
+
+	const uint32_t start = millis();
+	while (finished.load() < kTimers && millis() - start < 5000) {
+		delay(10);
+	}
+	TEST_ASSERT_EQUAL_UINT32(kTimers, finished.load());
+	lateness = timer.latenessStats().timeouts;
+	timer.deinit();
+}
+
+void reportLateness(const char *label, const ESPTimerLateness &lateness) {
+	char line[96];
+	snprintf(
+	    line,
+	    sizeof(line),
+	    "%s: p50 %lu ms, p99 %lu ms, max %lu ms",
+	    label,
+	    static_cast<unsigned long>(lateness.p50Ms),
+	    static_cast<unsigned long>(lateness.p99Ms),
+	    static_cast<unsigned long>(lateness.maxMs)
+	);
+	TEST_MESSAGE(line);
+}
+} // namespace
+
+void bench_p99_lateness_with_and_without_deadline_order() {
+	ESPTimerLateness slotOrder;
+	ESPTimerLateness deadlineOrder;
+	measureBurstLateness(false, slotOrder);
+	measureBurstLateness(true, deadlineOrder);
+	reportLateness("200 overdue timeouts, slot order", slotOrder);
+	reportLateness("200 overdue timeouts, deadline order", deadlineOrder);
+	TEST_ASSERT_TRUE(deadlineOrder.p99Ms <= slotOrder.p99Ms);
+}
+
+void setup() {
+	delay(2000);
+	UNITY_BEGIN();
+	RUN_TEST(bench_ms_lane_jitter_with_saturated_lanes);
+	RUN_TEST(bench_makespan_of_1000_simultaneous_expirations);
+	RUN_TEST(bench_p99_lateness_with_and_without_deadline_order);
+	UNITY_END();
+}
+
+void loop() {
+}